@@ -26,6 +26,8 @@ static struct
     struct arg_lit  * help;
     struct arg_lit  * version;
     struct arg_str  * extn;
+    struct arg_str  * emit;
+    struct arg_str  * hash;
     struct arg_file * file;
     struct arg_file * output;
     struct arg_end  * end;
@@ -48,12 +50,83 @@ typedef struct
     unsigned int index;
 }                  tArray;
 
+typedef struct
+{
+    char * keyword;
+    char * hashed;
+    char * lookup;
+} tParsedArray;
+
+/* everything the table emitters need to know about the keywords */
+typedef struct
+{
+    tParsedArray * parsed;          /* the keywords, in enum order */
+    unsigned int   keywordCount;
+    int            maxKeywordLen;
+    int            maxHashedLen;
+    int            nDigits;
+    tRecord     ** sorted;          /* every hashed string, in ascending hash order */
+    unsigned int   count;
+} tKeywordSet;
+
+/* the alternative forms the search table can be emitted in */
+typedef enum
+{
+    kEmitTree = 0,      /* binary search tree of tRecord, with explicit child indices */
+    kEmitEytzinger,     /* implicit breadth-first layout, children at 2i+1 and 2i+2 */
+    kEmitPerfect,       /* minimal perfect hash, bucket displacements and a dense slot array */
+    kEmitSplit,         /* sorted hashes, with the indices and strings in separate arrays */
+    kEmitSTree,         /* static B-tree, a cache line of hashes per node, implicit children */
+    kEmitCode,          /* no table, a lookup function the compiler can optimize */
+    kEmitRadix,         /* hashes grouped into buckets by their top bits, with bucket offsets */
+    kEmitSwiss,         /* open addressing, in groups of slots filtered by control bytes */
+    kEmitTrie,          /* no hashing, a double-array trie over the mapped characters */
+    kEmitComplete,      /* breadth-first, padded to a complete tree, searched in a fixed number of steps */
+    kEmitScan           /* an aligned, padded array of hashes, compared against all at once */
+} tEmitLayout;
+
+static const struct
+{
+    const char  * name;
+    tEmitLayout   layout;
+} kEmitLayouts[] = {
+    { "tree",      kEmitTree },
+    { "eytzinger", kEmitEytzinger },
+    { "perfect",   kEmitPerfect },
+    { "split",     kEmitSplit },
+    { "stree",     kEmitSTree },
+    { "code",      kEmitCode },
+    { "radix",     kEmitRadix },
+    { "swiss",     kEmitSwiss },
+    { "trie",      kEmitTrie },
+    { "complete",  kEmitComplete },
+    { "scan",      kEmitScan }
+};
+
 typedef struct
 {
     const char * executableName;
     const char * prefix;
     char       * reverseMapPrefix;
     const char * reverseUnsetEntry;
+    const char * emitOverride;
+    const char * hashOverride;
+    tHashFunction hashFunction;
+    tHash        seed;              /* the hash function's seed, zero unless searched for */
+    unsigned int seedSearch;        /* how many seeds to try, for one without collisions */
+    tEmitLayout  emit;
+    bool         emitDefault;       /* no layout was asked for, so it may depend on the size */
+    int          emitStrings;
+    int          hashBits;          /* 64, or 32 for narrowed tables */
+    double       bucketSize;        /* the average size of a radix bucket to aim for */
+    double       loadFactor;        /* the most a swiss table may be filled */
+    int          groupSize;         /* slots per swiss table group */
+    int          emitPool;          /* emit the hashed strings, to verify matches against */
+    int          emitDispatch;      /* emit a length and first character screen, too */
+    bool         charMapEmitted;
+    bool         charMapWide;       /* the flat map needs 16 bits, as there are symbols */
+    unsigned int filterProbes;      /* zero if no filter is to be emitted */
+    unsigned int filterBitsPerKey;
     FILE       * outputFile;
 } tGlobals;
 
@@ -67,6 +140,9 @@ tGlobals globals;
 
 tCharMap gCharMap[( 256 / ( 64 / 9 )) + 1];
 
+/* gCharMap folded to a byte per byte, for the word hash - built once it's complete */
+tWordMap gWordMap;
+
 const char * kHeaderPrefix =
                "/*\n"
                "    This file was automatically generated by the %s tool.\n"
@@ -78,6 +154,7 @@ const char * kHeaderPrefix =
                "#ifndef Once_%08x\n"
                "#define Once_%08x\n"
                "\n"
+               "#include <string.h>\n"
                "#include <libhashstrings.h>\n"
                "\n";
 
@@ -101,6 +178,74 @@ const char * kHashMapPrefix =
                "\n"
                "tRecord map%sSearch[] = {\n";
 
+const char * kEytzingerPrefix =
+               "/* pre-computed search table, in Eytzinger (breadth-first) order */\n"
+               "\n"
+               "%s map%sEytzingerHash[] = {\n";
+
+const char * kCompletePrefix =
+               "/* pre-computed search table, a complete tree of depth %u in breadth-first order */\n"
+               "\n"
+               "#define k%sCompleteDepth %u\n"
+               "\n"
+               "tHash map%sCompleteHash[] = {\n";
+
+const char * kSplitPrefix =
+               "/* pre-computed search table, as sorted hashes with separate indices */\n"
+               "\n"
+               "%s map%sSplitHash[] = {\n";
+
+const char * kScanPrefix =
+               "/* pre-computed table for a linear scan, padded to a multiple of %u entries */\n"
+               "\n";
+
+/* the most hashed strings the scan layout is chosen for, if no layout is asked for */
+static const unsigned int kScanMaximum = 64;
+
+const char * kSTreePrefix =
+               "/* pre-computed static B-tree, %d hashes to a node */\n"
+               "\n"
+               "tHash map%sSTreeHash[] __attribute__(( aligned( 64 ))) = {\n";
+
+const char * kRadixPrefix =
+               "/* pre-computed radix table, %u buckets averaging %.2f hashes */\n"
+               "\n"
+               "uint32_t map%sRadixOffset[] = {\n";
+
+/* the most bits of radix, i.e. 16M buckets */
+static const unsigned int kRadixMaxBits = 24;
+
+const char * kPerfectPrefix =
+               "/* pre-computed minimal perfect hash */\n"
+               "\n"
+               "uint32_t map%sPerfectDisplace[] = {\n";
+
+/* average number of keys per perfect hash bucket, and the number of seeds to try */
+static const unsigned int kPerfectBucketSize = 4;
+static const unsigned int kPerfectMaxSeeds   = 100;
+
+const char * kFilterPrefix =
+               "/* pre-computed blocked Bloom filter, %u probes, %u bits per key, */\n"
+               "/* measured false positive rate %.3f%% */\n"
+               "\n"
+               "uint64_t map%sFilterBits[] __attribute__(( aligned( 64 ))) = {\n";
+
+/* number of random hashes used to measure the filter's false positive rate */
+static const unsigned int kFilterTrials = 1 << 20;
+
+/* the seeds tried by a seed search are derived from this */
+static const tHash kSeedSearchSeed = 0x243f6a8885a308d3ULL;
+
+/* strings this long, or longer, share the last length bucket of a dispatch table */
+static const unsigned int kDispatchLengths = 32;
+
+const char * kLookupFunction =
+               "static inline t%sIndex lookup%sHash( %s hash )\n"
+               "{\n"
+               "    return (t%sIndex)%s;\n"
+               "}\n"
+               "\n";
+
 const char * kReverseMapPrefix = "const char * lookup%sAsString[]";
 
 /*****************************************/
@@ -210,8 +355,65 @@ int printParseError( const char * description, const char * filename, int lineNu
     return result;
 }
 
+/* the hash functions, by the name given in the .hash file and the name of the constant */
+static const struct
+{
+    const char    * name;
+    const char    * constant;
+    tHashFunction   function;
+} kHashFunctions[] = {
+    { "legacy",     "kHashLegacy",     kHashLegacy },
+    { "fnv1a",      "kHashFNV1a",      kHashFNV1a },
+    { "wyhash",     "kHashWyhash",     kHashWyhash },
+    { "crc32c",     "kHashCRC32C",     kHashCRC32C },
+    { "word",       "kHashWord",       kHashWord },
+    { "polynomial", "kHashPolynomial", kHashPolynomial }
+};
+
+const char * hashFunctionName( void )
+{
+    return kHashFunctions[ globals.hashFunction ].constant;
+}
+
+/* hash one of the dictionary's strings, as the emitted code will */
+tHash hashKeyword( tHash seed, const char * string, size_t length )
+{
+    if ( globals.hashFunction == kHashWord )
+    {
+        return hashStringWord( &gWordMap, seed, string, length );
+    }
+    return hashStringWith( globals.hashFunction, seed, string, length, gCharMap );
+}
+
+/*
+ * the same map, one entry per byte, so the hash needs no field extraction. It
+ * only needs to be 16 bits wide if there are symbols, which are mapped above 255
+ */
+void printFlatMap( void )
+{
+    bool wide = false;
+    for ( unsigned int i = 0; i < 256; i++ )
+    {
+        wide |= ( remapChar( gCharMap, i ) >= kSymbolOffset );
+    }
+    globals.charMapWide = wide;
+
+    fprintf( globals.outputFile, "%s g%sCharMapFlat[256] = {\n",
+             wide ? "uint16_t" : "uint8_t", globals.prefix );
+    for ( unsigned int i = 0; i < 256; i++ )
+    {
+        fprintf( globals.outputFile, "%s0x%0*x%s",
+                 ( i % 8 ) == 0 ? "    " : " ",
+                 wide ? 3 : 2, remapChar( gCharMap, i ),
+                 ( i < 255 ) ? (( i % 8 ) == 7 ? ",\n" : "," ) : "\n" );
+    }
+    fprintf( globals.outputFile, "};\n\n" );
+}
+
 void printMap( void )
 {
+    globals.charMapEmitted = true;
+
     fprintf( globals.outputFile, "uint64_t g%sCharMap[] = {\n", globals.prefix );
     for ( int i = 0; i < (( 256 / ( 64 / 9 )) + 1 ); i++ )
     {
@@ -249,6 +451,8 @@ void printMap( void )
         fprintf( globals.outputFile, " */\n" );
     }
     fprintf( globals.outputFile, "};\n\n" );
+
+    printFlatMap();
 }
 
 int processMapping( config_t * config )
@@ -422,178 +626,2107 @@ void fillTable( unsigned int depth,
     }
 }
 
-int processKeywords( config_t * config )
+/* the type of the emitted hashes, and the suffix of the functions that take it */
+const char * hashType( void )
 {
-    int result = 0;
-    config_setting_t * keywords;
+    return ( globals.hashBits == 32 ) ? "tHash32" : "tHash";
+}
 
-    unsigned int keywordCount;
-    typedef struct
+const char * hashSuffix( void )
+{
+    return ( globals.hashBits == 32 ) ? "32" : "";
+}
+
+/* a hash as a C literal, as wide as the emitted hashes */
+const char * hashLiteral( tHash hash )
+{
+    static char literal[ 24 ];
+
+    snprintf( literal, sizeof( literal ), "0x%0*lx", globals.hashBits / 4, hash );
+    return literal;
+}
+
+void printLookupFunction( const char * call )
+{
+    char * filtered = NULL;
+
+    /* reject most misses before the search even starts */
+    if ( globals.filterProbes != 0 )
     {
-        char * keyword;
-        char * hashed;
-        char * lookup;
-    } tParsedArray;
+        asprintf( &filtered, "( mayContainHash( &map%sFilter, hash ) ? %s : k%sUnset )",
+                  globals.prefix, call, globals.prefix );
+        call = filtered;
+    }
+    fprintf( globals.outputFile, kLookupFunction,
+             globals.prefix, globals.prefix, hashType(), globals.prefix, call );
+    free( filtered );
+}
 
-    tRecord * skipTable;
+/* the binary search tree of tRecord, map<Prefix>Search[], as findHash() and dumpHashMap() take it */
+int printSearchTree( tKeywordSet * set )
+{
+    int result = 0;
+    unsigned int i;
 
-    keywords = config_lookup( config, "keywords" );
-    if ( keywords == NULL || !config_setting_is_array( keywords ))
+    tRecord * skipTable = (tRecord *)calloc( set->count, sizeof( tRecord ));
+    if ( skipTable == NULL)
     {
-        printError( "\'keywords\' must be a array, in file \"%s\" at line %d",
-                    config_setting_source_file( keywords ),
-                    config_setting_source_line( keywords ));
+        printError( "failed to allocate memory" );
+        result = -1;
     }
     else
     {
-        config_setting_t * element;
-        unsigned int i = 0;
-
-        struct btree * tree;
-        tRecord record;
-
-        keywordCount = config_setting_length( keywords );
+        fillTable( 0, skipTable, set->sorted, 0, set->count );
 
-        int       nDigits = 1;
-        for ( int i       = keywordCount; i > 10; i /= 10 ) { ++nDigits; }
+        fprintf( globals.outputFile, kHashMapPrefix, globals.prefix );
 
-        tParsedArray * parsedArray = calloc( keywordCount, sizeof( tParsedArray ));
-        if ( parsedArray == NULL)
+        for ( i = 0; i < set->count; i++ )
         {
-            printError( "failed to allocate memory" );
+            fprintf(
+                globals.outputFile,
+                "    { 0x%016lx, \"%s\",%*ck%s%s,%*c%*u, %*u }",
+                skipTable[ i ].hash,
+                skipTable[ i ].hashedString,
+                (int)( strlen( skipTable[ i ].hashedString ) - set->maxHashedLen - 1 ), ' ',
+                globals.prefix, set->parsed[ skipTable[ i ].index ].keyword,
+                (int)( strlen( set->parsed[ skipTable[ i ].index ].keyword ) - set->maxKeywordLen - 1 ), ' ',
+                set->nDigits, skipTable[ i ].lower,
+                set->nDigits, skipTable[ i ].higher );
+            if ( i < set->count - 1 )
+            {
+                fputc( ',', globals.outputFile );
+            }
+            fputc( '\n', globals.outputFile );
         }
-        else
-        {
-            const char * src;
-            const char * anchor;
 
-            for ( i = 0; i < keywordCount; i++ )
-            {
-                element = config_setting_get_elem( keywords, i );
-                if ( element != NULL)
-                {
-                    if ( config_setting_type( element ) != CONFIG_TYPE_STRING )
-                    {
-                        printError( "keyword must be a string, in file \"%s\" at line %d",
-                                    config_setting_source_file( element ),
-                                    config_setting_source_line( element ));
-                    }
-                    else
-                    {
-                        const char * keyword = config_setting_get_string( element );
-                        if ( keyword != NULL)
-                        {
-                            src    = keyword;
-                            anchor = keyword;
-                            int commaCounter = 0;
+        fprintf( globals.outputFile, "};\n\n" );
 
-                            do
-                            {
-                                switch ( *src )
-                                {
-                                case ',':
-                                    if ( commaCounter == 0 )
-                                    {
-                                        /* end of initial keyword, but we have at least one more term to hash */
-                                        parsedArray[ i ].keyword = strndup( anchor, src - anchor );
-                                        anchor = &src[ 1 ]; /* drop anchor at the start of the hashed words */
-                                    }
-                                    else if ( commaCounter == 1 )
-                                    {
-                                        size_t size = ( src - anchor ) + 2 + 1;
-                                        char * lookup = calloc( 1, size );
-                                        if ( lookup != NULL)
-                                        {
-                                            const char * s = anchor;
-                                            char       * d = lookup;
-                                            *d++ = '\"';
-                                            while ( s < src )
-                                            {
-                                                *d++ = *s++;
-                                            }
-                                            *d++ = '\"';
-                                            *d   = '\0';
-                                            parsedArray[ i ].lookup = lookup;
-                                        }
-                                    }
+        free( skipTable );
+    }
+    return result;
+}
 
-                                    ++commaCounter;
-                                    break;
+int emitTree( tKeywordSet * set )
+{
+    char * call;
 
-                                    /* semicolon means end of hash list & start of explicit reverse lookup string */
-                                case ';':
-                                    if ( commaCounter == 0 )
-                                    {
-                                        /* end of initial keyword, but we have at least one more term to hash */
-                                        parsedArray[ i ].keyword = strndup( anchor, src - anchor );
-                                    }
-                                    parsedArray[ i ].hashed =
-                                        strndup( anchor, src - anchor );  /* remember the list of hashed words */
+    int result = printSearchTree( set );
+    if ( result == 0 )
+    {
+        asprintf( &call, "findHash( map%sSearch, hash )", globals.prefix );
+        printLookupFunction( call );
+        free( call );
+    }
+    return result;
+}
 
-                                    do { ++src; } while (isspace( *src ));
+/*
+ * an in-order walk of the implicit tree hands out the sorted
+ * records in ascending order, which is all it takes to build it
+ */
+unsigned int fillEytzinger( tRecord ** eytzinger,
+                            tRecord ** sorted,
+                            unsigned int count,
+                            unsigned int next,
+                            unsigned int i )
+{
+    if ( i < count )
+    {
+        next = fillEytzinger( eytzinger, sorted, count, next, 2 * i + 1 );
+        eytzinger[ i ] = sorted[ next++ ];
+        next = fillEytzinger( eytzinger, sorted, count, next, 2 * i + 2 );
+    }
+    return next;
+}
 
-                                    /* don't leak the existing reverse lookup string, if there is one */
-                                    if ( parsedArray[ i ].lookup != NULL)
-                                    {
-                                        free( parsedArray[ i ].lookup );
-                                        parsedArray[ i ].lookup = NULL;
-                                    }
-                                    parsedArray[ i ].lookup =
-                                        strdup( src ); /* remember the explicit reverse lookup provided */
-                                    /* terminate the loop */
-                                    src = "";
-                                    break;
+int emitEytzinger( tKeywordSet * set )
+{
+    int result = 0;
+    unsigned int i;
+    char * call;
 
-                                case '\0':
-                                default:break;
-                                }
-                            } while ( *src++ != '\0' );
+    tRecord ** eytzinger = calloc( set->count, sizeof( tRecord * ));
+    if ( eytzinger == NULL)
+    {
+        printError( "failed to allocate memory" );
+        result = -1;
+    }
+    else
+    {
+        fillEytzinger( eytzinger, set->sorted, set->count, 0, 0 );
 
-                            if ( parsedArray[ i ].keyword == NULL)
-                            {
-                                parsedArray[ i ].keyword = strdup( anchor );
-                            }
+        fprintf( globals.outputFile, kEytzingerPrefix, hashType(), globals.prefix );
+        for ( i = 0; i < set->count; i++ )
+        {
+            fprintf( globals.outputFile, "    %s%c  /* \"%s\" */\n",
+                     hashLiteral( eytzinger[ i ]->hash ),
+                     ( i < set->count - 1 ) ? ',' : ' ',
+                     eytzinger[ i ]->hashedString );
+        }
+        fprintf( globals.outputFile, "};\n\n" );
 
-                            if ( parsedArray[ i ].hashed == NULL)
-                            {
-                                parsedArray[ i ].hashed = strdup( anchor );
-                            }
+        fprintf( globals.outputFile, "tIndex map%sEytzingerIndex[] = {\n", globals.prefix );
+        for ( i = 0; i < set->count; i++ )
+        {
+            fprintf( globals.outputFile, "    k%s%s%c\n",
+                     globals.prefix, set->parsed[ eytzinger[ i ]->index ].keyword,
+                     ( i < set->count - 1 ) ? ',' : ' ' );
+        }
+        fprintf( globals.outputFile, "};\n\n" );
 
-                            if ( parsedArray[ i ].lookup == NULL)
-                            {
-                                /* if reverse lookup isn't already set to something better, use the keyword */
-                                asprintf( &parsedArray[ i ].lookup, "\"%s\"", anchor );
-                            }
-                        }
-                    }
-                }
-            }
+        asprintf( &call, "findHashEytzinger%s( map%sEytzingerHash, map%sEytzingerIndex, %u, hash )",
+                  hashSuffix(), globals.prefix, globals.prefix, set->count );
+        printLookupFunction( call );
+        free( call );
 
-            int maxKeywordLen = 0;
-            for ( i = 0; i < keywordCount; i++ )
+        free( eytzinger );
+    }
+    return result;
+}
+
+/*
+ * the Eytzinger layout again, but padded with sentinel hashes (greater than or equal
+ * to every real one, so they sort last) until the tree is complete, and shifted up
+ * by one so the children of i are at 2i and 2i+1. Slot 0 is never part of the tree.
+ */
+int emitComplete( tKeywordSet * set )
+{
+    int result = 0;
+    unsigned int i;
+    unsigned int depth = 1;
+    char * call;
+
+    while ((( 1u << depth ) - 1 ) < set->count ) { depth++; }
+    unsigned int nodes = ( 1u << depth ) - 1;
+
+    tRecord ** padded   = calloc( nodes, sizeof( tRecord * ));
+    tRecord ** complete = calloc( nodes, sizeof( tRecord * ));
+    if ( padded == NULL || complete == NULL)
+    {
+        printError( "failed to allocate memory" );
+        result = -1;
+    }
+    else
+    {
+        /* the padding is left NULL, and emitted as sentinels */
+        memcpy( padded, set->sorted, set->count * sizeof( tRecord * ));
+        fillEytzinger( complete, padded, nodes, 0, 0 );
+
+        fprintf( globals.outputFile, kCompletePrefix, depth, globals.prefix, depth, globals.prefix );
+        fprintf( globals.outputFile, "    0x%016lx,  /* (unused) */\n", 0UL );
+        for ( i = 0; i < nodes; i++ )
+        {
+            if ( complete[ i ] != NULL )
             {
-                maxKeywordLen = max( maxKeywordLen, strlen( parsedArray[ i ].keyword ));
+                fprintf( globals.outputFile, "    0x%016lx%c  /* \"%s\" */\n",
+                         complete[ i ]->hash,
+                         ( i < nodes - 1 ) ? ',' : ' ',
+                         complete[ i ]->hashedString );
             }
-
-            /* emit the enum */
-            fprintf( globals.outputFile, kHashEnumPrefix, globals.prefix );
-            for ( i = 0; i < keywordCount; i++ )
+            else
             {
-                fprintf( globals.outputFile,
-                         "    k%s%*s = %*u,\n",
-                         globals.prefix, -maxKeywordLen, parsedArray[ i ].keyword, nDigits, i + 1 );
+                fprintf( globals.outputFile, "    0x%016lx%c  /* (padding) */\n",
+                         ~0UL, ( i < nodes - 1 ) ? ',' : ' ' );
             }
-            fprintf( globals.outputFile, kHashEnumSuffix,
-                     globals.prefix, i + 1, globals.prefix );
+        }
+        fprintf( globals.outputFile, "};\n\n" );
 
-            /* emit the enum -> string lookup */
-            if ( globals.reverseMapPrefix == NULL)
+        fprintf( globals.outputFile, "tIndex map%sCompleteIndex[] = {\n", globals.prefix );
+        fprintf( globals.outputFile, "    k%sUnset,\n", globals.prefix );
+        for ( i = 0; i < nodes; i++ )
+        {
+            if ( complete[ i ] != NULL )
             {
-                asprintf( &globals.reverseMapPrefix, kReverseMapPrefix, globals.prefix );
+                fprintf( globals.outputFile, "    k%s%s%c\n",
+                         globals.prefix, set->parsed[ complete[ i ]->index ].keyword,
+                         ( i < nodes - 1 ) ? ',' : ' ' );
             }
-            fprintf( globals.outputFile, "%s", globals.reverseMapPrefix );
-
-            fprintf( globals.outputFile, " = {\n" );
+            else
+            {
+                fprintf( globals.outputFile, "    k%sUnset%c\n",
+                         globals.prefix, ( i < nodes - 1 ) ? ',' : ' ' );
+            }
+        }
+        fprintf( globals.outputFile, "};\n\n" );
+
+        asprintf( &call, "findHashComplete( map%sCompleteHash, map%sCompleteIndex, k%sCompleteDepth, hash )",
+                  globals.prefix, globals.prefix, globals.prefix );
+        printLookupFunction( call );
+        free( call );
+    }
+
+    free( padded );
+    free( complete );
+
+    return result;
+}
+
+int emitSplit( tKeywordSet * set )
+{
+    unsigned int i;
+    char * call;
+
+    fprintf( globals.outputFile, kSplitPrefix, hashType(), globals.prefix );
+    for ( i = 0; i < set->count; i++ )
+    {
+        fprintf( globals.outputFile, "    %s%c  /* \"%s\" */\n",
+                 hashLiteral( set->sorted[ i ]->hash ),
+                 ( i < set->count - 1 ) ? ',' : ' ',
+                 set->sorted[ i ]->hashedString );
+    }
+    fprintf( globals.outputFile, "};\n\n" );
+
+    fprintf( globals.outputFile, "tIndex map%sSplitIndex[] = {\n", globals.prefix );
+    for ( i = 0; i < set->count; i++ )
+    {
+        fprintf( globals.outputFile, "    k%s%s%c\n",
+                 globals.prefix, set->parsed[ set->sorted[ i ]->index ].keyword,
+                 ( i < set->count - 1 ) ? ',' : ' ' );
+    }
+    fprintf( globals.outputFile, "};\n\n" );
+
+    /* the lookup never touches this, so it is only emitted on request */
+    if ( globals.emitStrings )
+    {
+        fprintf( globals.outputFile, "const char * map%sSplitString[] = {\n", globals.prefix );
+        for ( i = 0; i < set->count; i++ )
+        {
+            fprintf( globals.outputFile, "    \"%s\"%c\n",
+                     set->sorted[ i ]->hashedString,
+                     ( i < set->count - 1 ) ? ',' : ' ' );
+        }
+        fprintf( globals.outputFile, "};\n\n" );
+    }
+
+    asprintf( &call, "findHashSplit%s( map%sSplitHash, map%sSplitIndex, %u, hash )",
+              hashSuffix(), globals.prefix, globals.prefix, set->count );
+    printLookupFunction( call );
+    free( call );
+
+    return 0;
+}
+
+/* the arrays of a scan table */
+typedef enum
+{
+    kScanKey,           /* the hash, narrowed, to be compared */
+    kScanHash,          /* the hash, as wide as hashBits */
+    kScanIndex
+} tScanArray;
+
+/* one array of a scan table, one entry per line, then the padding */
+void printScanArray( tKeywordSet * set, unsigned int count, const char * declaration, tScanArray array )
+{
+    fprintf( globals.outputFile, declaration, globals.prefix );
+    for ( unsigned int i = 0; i < count; i++ )
+    {
+        tRecord * record = ( i < set->count ) ? set->sorted[ i ] : NULL;
+        char separator = ( i < count - 1 ) ? ',' : ' ';
+
+        if ( array == kScanIndex )
+        {
+            fprintf( globals.outputFile, "    k%s%s%c\n", globals.prefix,
+                     ( record != NULL ) ? set->parsed[ record->index ].keyword : "Unset", separator );
+            continue;
+        }
+
+        if ( array == kScanKey )
+        {
+            fprintf( globals.outputFile, "    0x%08x%c", ( record != NULL ) ? narrowHash( record->hash ) : 0, separator );
+        }
+        else
+        {
+            fprintf( globals.outputFile, "    %s%c", hashLiteral(( record != NULL ) ? record->hash : 0 ), separator );
+        }
+
+        if ( record != NULL )
+        {
+            fprintf( globals.outputFile, "  /* \"%s\" */\n", record->hashedString );
+        }
+        else
+        {
+            fprintf( globals.outputFile, "  /* (padding) */\n" );
+        }
+    }
+    fprintf( globals.outputFile, "};\n\n" );
+}
+
+/*
+ * a dictionary this small fits in a few vector registers, so it is compared against
+ * every entry at once. With 64-bit hashes, what's compared is a 32-bit key of each,
+ * twice as many to a register, and only a matching key's hash is compared in full
+ */
+int emitScan( tKeywordSet * set )
+{
+    unsigned int count = ( set->count + kScanPadding - 1 ) & ~( kScanPadding - 1 );
+    char * call;
+
+    fprintf( globals.outputFile, kScanPrefix, kScanPadding );
+    if ( globals.hashBits == 32 )
+    {
+        printScanArray( set, count, "tHash32 map%sScanHash[] __attribute__(( aligned( 32 ))) = {\n", kScanHash );
+        printScanArray( set, count, "tIndex map%sScanIndex[] = {\n", kScanIndex );
+
+        asprintf( &call, "findHashScan32( map%sScanHash, map%sScanIndex, %u, hash )",
+                  globals.prefix, globals.prefix, count );
+    }
+    else
+    {
+        printScanArray( set, count, "tHash32 map%sScanKey[] __attribute__(( aligned( 32 ))) = {\n", kScanKey );
+        printScanArray( set, count, "tHash map%sScanHash[] = {\n", kScanHash );
+        printScanArray( set, count, "tIndex map%sScanIndex[] = {\n", kScanIndex );
+
+        asprintf( &call, "findHashScan( map%sScanKey, map%sScanHash, map%sScanIndex, %u, hash )",
+                  globals.prefix, globals.prefix, globals.prefix, count );
+    }
+    printLookupFunction( call );
+    free( call );
+
+    return 0;
+}
+
+/*
+ * the same in-order walk as fillEytzinger(), but over nodes of kSTreeKeys
+ * hashes, each with kSTreeKeys+1 children. Once the records run out, the
+ * remaining positions are left NULL, and emitted as padding.
+ */
+unsigned int fillSTree( tRecord ** stree,
+                        tRecord ** sorted,
+                        unsigned int count,
+                        unsigned int nodes,
+                        unsigned int next,
+                        unsigned int k )
+{
+    if ( k < nodes )
+    {
+        for ( unsigned int i = 0; i < kSTreeKeys; i++ )
+        {
+            next = fillSTree( stree, sorted, count, nodes, next, k * ( kSTreeKeys + 1 ) + i + 1 );
+            if ( next < count )
+            {
+                stree[ k * kSTreeKeys + i ] = sorted[ next++ ];
+            }
+        }
+        next = fillSTree( stree, sorted, count, nodes, next, k * ( kSTreeKeys + 1 ) + kSTreeKeys + 1 );
+    }
+    return next;
+}
+
+int emitSTree( tKeywordSet * set )
+{
+    int result = 0;
+    unsigned int i;
+    char * call;
+
+    unsigned int nodes = ( set->count + kSTreeKeys - 1 ) / kSTreeKeys;
+    unsigned int total = nodes * kSTreeKeys;
+
+    tRecord ** stree = calloc( total, sizeof( tRecord * ));
+    if ( stree == NULL)
+    {
+        printError( "failed to allocate memory" );
+        result = -1;
+    }
+    else
+    {
+        fillSTree( stree, set->sorted, set->count, nodes, 0, 0 );
+
+        /* padding sorts after everything, and is never matched to a keyword */
+        fprintf( globals.outputFile, kSTreePrefix, kSTreeKeys, globals.prefix );
+        for ( i = 0; i < total; i++ )
+        {
+            if ( i % kSTreeKeys == 0 )
+            {
+                fprintf( globals.outputFile, "    /* node %u */\n", i / kSTreeKeys );
+            }
+            if ( stree[ i ] != NULL)
+            {
+                fprintf( globals.outputFile, "    0x%016lx%c  /* \"%s\" */\n",
+                         stree[ i ]->hash, ( i < total - 1 ) ? ',' : ' ', stree[ i ]->hashedString );
+            }
+            else
+            {
+                fprintf( globals.outputFile, "    0x%016lx%c\n",
+                         (tHash)~0ULL, ( i < total - 1 ) ? ',' : ' ' );
+            }
+        }
+        fprintf( globals.outputFile, "};\n\n" );
+
+        fprintf( globals.outputFile, "tIndex map%sSTreeIndex[] = {\n", globals.prefix );
+        for ( i = 0; i < total; i++ )
+        {
+            fprintf( globals.outputFile, "    k%s%s%c\n",
+                     globals.prefix,
+                     ( stree[ i ] != NULL ) ? set->parsed[ stree[ i ]->index ].keyword : "Unset",
+                     ( i < total - 1 ) ? ',' : ' ' );
+        }
+        fprintf( globals.outputFile, "};\n\n" );
+
+        asprintf( &call, "findHashSTree( map%sSTreeHash, map%sSTreeIndex, %u, hash )",
+                  globals.prefix, globals.prefix, nodes );
+        printLookupFunction( call );
+        free( call );
+
+        free( stree );
+    }
+    return result;
+}
+
+/*
+ * choose the fewest bits of radix that bring the average bucket down to the target
+ * size, then group the hashes by bucket with a counting sort - which keeps them in
+ * ascending order within each bucket.
+ */
+int emitRadix( tKeywordSet * set )
+{
+    int result = 0;
+    unsigned int i;
+    unsigned int bits = 0;
+    char * call;
+
+    while ( bits < kRadixMaxBits && set->count > globals.bucketSize * ( 1U << bits ))
+    {
+        bits++;
+    }
+
+    uint32_t   buckets = 1U << bits;
+    uint32_t * offsets = calloc( buckets + 1, sizeof( uint32_t ));
+    tRecord ** radix   = calloc( set->count, sizeof( tRecord * ));
+
+    if ( offsets == NULL || radix == NULL)
+    {
+        printError( "failed to allocate memory" );
+        result = -1;
+    }
+    else
+    {
+        for ( i = 0; i < set->count; i++ )
+        {
+            offsets[ radixBucket( set->sorted[ i ]->hash, bits ) + 1 ]++;
+        }
+        for ( i = 0; i < buckets; i++ )
+        {
+            offsets[ i + 1 ] += offsets[ i ];
+        }
+        for ( i = 0; i < set->count; i++ )
+        {
+            radix[ offsets[ radixBucket( set->sorted[ i ]->hash, bits ) ]++ ] = set->sorted[ i ];
+        }
+        /* placing them advanced each offset to the start of the next bucket, so shift them back */
+        memmove( &offsets[ 1 ], &offsets[ 0 ], buckets * sizeof( uint32_t ));
+        offsets[ 0 ] = 0;
+
+        fprintf( globals.outputFile, kRadixPrefix,
+                 buckets, (double)set->count / buckets, globals.prefix );
+        for ( i = 0; i <= buckets; i++ )
+        {
+            fprintf( globals.outputFile, "%s%u%s",
+                     ( i % 8 ) == 0 ? "    " : " ",
+                     offsets[ i ],
+                     ( i < buckets ) ? (( i % 8 ) == 7 ? ",\n" : "," ) : "\n" );
+        }
+        fprintf( globals.outputFile, "};\n\n" );
+
+        fprintf( globals.outputFile, "tHash map%sRadixHash[] = {\n", globals.prefix );
+        for ( i = 0; i < set->count; i++ )
+        {
+            fprintf( globals.outputFile, "    0x%016lx,  /* \"%s\" */\n",
+                     radix[ i ]->hash, radix[ i ]->hashedString );
+        }
+        for ( i = 0; i < kRadixPadding; i++ )
+        {
+            fprintf( globals.outputFile, "    0x%016lx%c\n", (tHash)~0ULL, ( i < kRadixPadding - 1 ) ? ',' : ' ' );
+        }
+        fprintf( globals.outputFile, "};\n\n" );
+
+        fprintf( globals.outputFile, "tIndex map%sRadixIndex[] = {\n", globals.prefix );
+        for ( i = 0; i < set->count; i++ )
+        {
+            fprintf( globals.outputFile, "    k%s%s,\n",
+                     globals.prefix, set->parsed[ radix[ i ]->index ].keyword );
+        }
+        for ( i = 0; i < kRadixPadding; i++ )
+        {
+            fprintf( globals.outputFile, "    k%sUnset%c\n", globals.prefix, ( i < kRadixPadding - 1 ) ? ',' : ' ' );
+        }
+        fprintf( globals.outputFile, "};\n\n" );
+
+        asprintf( &call, "findHashRadix( map%sRadixOffset, %u, map%sRadixHash, map%sRadixIndex, hash )",
+                  globals.prefix, bits, globals.prefix, globals.prefix );
+        printLookupFunction( call );
+        free( call );
+    }
+
+    free( offsets );
+    free( radix );
+
+    return result;
+}
+
+/*
+ * the smallest power-of-two number of groups that keeps the load at or below the load
+ * factor, then insert each hash at the first empty slot in its probe sequence - the same
+ * sequence findHashSwiss() follows.
+ */
+int emitSwiss( tKeywordSet * set )
+{
+    int result = 0;
+    unsigned int i;
+    uint32_t groupBits = 0;
+    char * call;
+
+    while ((( 1U << groupBits ) * globals.groupSize ) * globals.loadFactor < set->count )
+    {
+        groupBits++;
+    }
+
+    uint32_t   groups   = 1U << groupBits;
+    uint32_t   slots    = groups * globals.groupSize;
+    uint8_t  * control  = malloc( slots );
+    tRecord ** slot     = calloc( slots, sizeof( tRecord * ));
+
+    if ( control == NULL || slot == NULL)
+    {
+        printError( "failed to allocate memory" );
+        result = -1;
+    }
+    else
+    {
+        memset( control, kSwissEmpty, slots );
+
+        for ( i = 0; i < set->count; i++ )
+        {
+            tHash    mixed = perfectMix( set->sorted[ i ]->hash, kSwissSeed );
+            uint32_t group = swissGroup( mixed, groupBits );
+            uint32_t step  = 1;
+            uint32_t j;
+
+            for ( ;; )
+            {
+                for ( j = 0; j < (uint32_t)globals.groupSize; j++ )
+                {
+                    if ( control[ group * globals.groupSize + j ] == kSwissEmpty ) break;
+                }
+                if ( j < (uint32_t)globals.groupSize ) break;
+                group = ( group + step++ ) & ( groups - 1 );
+            }
+            control[ group * globals.groupSize + j ] = swissControl( mixed );
+            slot[ group * globals.groupSize + j ] = set->sorted[ i ];
+        }
+
+        fprintf( globals.outputFile,
+                 "/* pre-computed swiss table, %u groups of %d slots, %.1f%% full */\n"
+                 "\n"
+                 "uint8_t map%sSwissControl[] __attribute__(( aligned( 16 ))) = {\n",
+                 groups, globals.groupSize, ( 100.0 * set->count ) / slots, globals.prefix );
+        for ( i = 0; i < slots; i++ )
+        {
+            fprintf( globals.outputFile, "%s0x%02x%s",
+                     ( i % globals.groupSize ) == 0 ? "    " : " ",
+                     control[ i ],
+                     ( i < slots - 1 ) ? (( i % globals.groupSize ) == (unsigned)globals.groupSize - 1 ? ",\n" : "," ) : "\n" );
+        }
+        fprintf( globals.outputFile, "};\n\n" );
+
+        fprintf( globals.outputFile, "tSlot map%sSwissSlot[] = {\n", globals.prefix );
+        for ( i = 0; i < slots; i++ )
+        {
+            if ( slot[ i ] != NULL)
+            {
+                fprintf( globals.outputFile, "    { 0x%016lx, k%s%s }%c%*c/* \"%s\" */\n",
+                         slot[ i ]->hash,
+                         globals.prefix, set->parsed[ slot[ i ]->index ].keyword,
+                         ( i < slots - 1 ) ? ',' : ' ',
+                         (int)( strlen( set->parsed[ slot[ i ]->index ].keyword ) - set->maxKeywordLen - 1 ), ' ',
+                         slot[ i ]->hashedString );
+            }
+            else
+            {
+                fprintf( globals.outputFile, "    { 0, k%sUnset }%c\n",
+                         globals.prefix, ( i < slots - 1 ) ? ',' : ' ' );
+            }
+        }
+        fprintf( globals.outputFile, "};\n\n" );
+
+        fprintf( globals.outputFile,
+                 "tSwissTable map%sSwiss = { %u, %d, map%sSwissControl, map%sSwissSlot };\n\n",
+                 globals.prefix, groupBits, globals.groupSize, globals.prefix, globals.prefix );
+
+        asprintf( &call, "findHashSwiss( &map%sSwiss, hash )", globals.prefix );
+        printLookupFunction( call );
+        free( call );
+    }
+
+    free( control );
+    free( slot );
+
+    return result;
+}
+
+/* a conventional trie, built first and then packed into the double array */
+typedef struct
+{
+    uint32_t firstChild;
+    uint32_t nextSibling;
+    uint16_t label;
+    tIndex   accept;
+    uint32_t position;      /* where it was placed in the double array */
+} tTrieBuild;
+
+/*
+ * The mapped characters that occur in the keywords are numbered from 1, and every
+ * byte is given the number of the character it maps to. Each keyword's strings are
+ * added to a conventional trie, which is then packed breadth-first into a double
+ * array: each state gets the lowest base at which all of its children's positions
+ * (base + label) are free.
+ */
+int emitTrie( tKeywordSet * set )
+{
+    int result = 0;
+    unsigned int i;
+    uint16_t     label[ 512 ] = { 0 };
+    uint16_t     class[ 256 ];
+    uint16_t     labels = 0;
+
+    tTrieBuild * trie     = NULL;
+    uint32_t     nodes    = 1;      /* node 0 is the root */
+    uint32_t     capacity = 1024;
+
+    /* number the mapped characters the keywords use */
+    for ( i = 0; i < set->keywordCount; i++ )
+    {
+        for ( const char * src = set->parsed[ i ].hashed; *src != '\0'; src++ )
+        {
+            tMappedChar c = remapChar( gCharMap, *src );
+            if ( *src != ',' && label[ c ] == 0 )
+            {
+                label[ c ] = ++labels;
+            }
+        }
+    }
+    for ( i = 0; i < 256; i++ )
+    {
+        class[ i ] = label[ remapChar( gCharMap, i ) ];
+    }
+
+    trie = calloc( capacity, sizeof( tTrieBuild ));
+    if ( trie == NULL)
+    {
+        printError( "failed to allocate memory" );
+        return -1;
+    }
+
+    for ( i = 0; i < set->keywordCount && result == 0; i++ )
+    {
+        const char * src = set->parsed[ i ].hashed;
+        while ( *src != '\0' && result == 0 )
+        {
+            const char * hashedString = src;
+            uint32_t node = 0;
+
+            for ( ; *src != '\0' && *src != ','; src++ )
+            {
+                uint16_t c = class[ (unsigned char)*src ];
+                uint32_t child;
+
+                for ( child = trie[ node ].firstChild; child != 0; child = trie[ child ].nextSibling )
+                {
+                    if ( trie[ child ].label == c ) break;
+                }
+                if ( child == 0 )
+                {
+                    if ( nodes == capacity )
+                    {
+                        tTrieBuild * larger = realloc( trie, 2 * capacity * sizeof( tTrieBuild ));
+                        if ( larger == NULL)
+                        {
+                            printError( "failed to allocate memory" );
+                            result = -1;
+                            break;
+                        }
+                        memset( &larger[ capacity ], 0, capacity * sizeof( tTrieBuild ));
+                        trie = larger;
+                        capacity *= 2;
+                    }
+                    child = nodes++;
+                    trie[ child ].label       = c;
+                    trie[ child ].nextSibling = trie[ node ].firstChild;
+                    trie[ node ].firstChild   = child;
+                }
+                node = child;
+            }
+
+            /* as with the hashes, a later keyword replaces an earlier one */
+            if ( result == 0 && trie[ node ].accept != kIndexUnset && trie[ node ].accept != i + 1 )
+            {
+                printError( "\"%.*s\" (k%s%s) maps to the same characters as a string of k%s%s",
+                            (int)( src - hashedString ), hashedString,
+                            globals.prefix, set->parsed[ i ].keyword,
+                            globals.prefix, set->parsed[ trie[ node ].accept - 1 ].keyword );
+            }
+            trie[ node ].accept = i + 1;
+
+            if ( *src != '\0' ) { ++src; }
+        }
+    }
+
+    /* pack it into the double array, in breadth-first order */
+    uint32_t   size   = kTrieRoot + 1;
+    uint32_t   limit  = 2 * nodes + labels + 2;   /* first fit never needs more than this */
+    uint32_t * queue  = calloc( nodes, sizeof( uint32_t ));
+    uint32_t * base   = calloc( limit, sizeof( uint32_t ));
+    uint32_t * check  = calloc( limit, sizeof( uint32_t ));
+    tIndex   * accept = calloc( limit, sizeof( tIndex ));
+    bool     * used   = calloc( limit, sizeof( bool ));
+
+    if ( result == 0 && ( queue == NULL || base == NULL || check == NULL || accept == NULL || used == NULL ))
+    {
+        printError( "failed to allocate memory" );
+        result = -1;
+    }
+
+    if ( result == 0 )
+    {
+        uint32_t head = 0, tail = 0;
+        uint32_t firstFree = kTrieRoot + 1;
+
+        used[ 0 ] = used[ kTrieRoot ] = true;
+        trie[ 0 ].position = kTrieRoot;
+        queue[ tail++ ] = 0;
+
+        while ( head < tail )
+        {
+            uint32_t node = queue[ head++ ];
+            uint32_t position = trie[ node ].position;
+            uint32_t child;
+
+            accept[ position ] = trie[ node ].accept;
+            if ( trie[ node ].firstChild == 0 )
+            {
+                continue;
+            }
+
+            while ( used[ firstFree ] ) { firstFree++; }
+
+            uint32_t b = ( firstFree > trie[ trie[ node ].firstChild ].label )
+                         ? firstFree - trie[ trie[ node ].firstChild ].label : 1;
+            for ( ;; b++ )
+            {
+                for ( child = trie[ node ].firstChild; child != 0; child = trie[ child ].nextSibling )
+                {
+                    if ( used[ b + trie[ child ].label ] ) break;
+                }
+                if ( child == 0 ) break;
+            }
+
+            base[ position ] = b;
+            for ( child = trie[ node ].firstChild; child != 0; child = trie[ child ].nextSibling )
+            {
+                uint32_t t = b + trie[ child ].label;
+                used[ t ]  = true;
+                check[ t ] = position;
+                trie[ child ].position = t;
+                queue[ tail++ ] = child;
+                if ( size <= t ) { size = t + 1; }
+            }
+        }
+
+        /* a state's base plus any label must stay within the array */
+        for ( i = 0; i < size; i++ )
+        {
+            if ( size < base[ i ] + labels + 1 ) { size = base[ i ] + labels + 1; }
+        }
+
+        fprintf( globals.outputFile,
+                 "/* pre-computed double-array trie, %u states in %u positions */\n"
+                 "\n"
+                 "uint16_t map%sTrieClass[256] = {\n",
+                 nodes, size, globals.prefix );
+        for ( i = 0; i < 256; i++ )
+        {
+            fprintf( globals.outputFile, "%s%3u%s",
+                     ( i % 16 ) == 0 ? "    " : " ",
+                     class[ i ],
+                     ( i < 255 ) ? (( i % 16 ) == 15 ? ",\n" : "," ) : "\n" );
+        }
+        fprintf( globals.outputFile, "};\n\n" );
+
+        fprintf( globals.outputFile, "tTrieNode map%sTrieNode[] = {\n", globals.prefix );
+        for ( i = 0; i < size; i++ )
+        {
+            fprintf( globals.outputFile, "%s{ %u, %u }%s",
+                     ( i % 8 ) == 0 ? "    " : " ",
+                     base[ i ], check[ i ],
+                     ( i < size - 1 ) ? (( i % 8 ) == 7 ? ",\n" : "," ) : "\n" );
+        }
+        fprintf( globals.outputFile, "};\n\n" );
+
+        /* sized explicitly, as the states that accept nothing are left out */
+        fprintf( globals.outputFile, "tIndex map%sTrieAccept[%u] = {\n", globals.prefix, size );
+        bool accepting = false;
+        for ( i = 0; i < size; i++ )
+        {
+            if ( accept[ i ] != kIndexUnset )
+            {
+                fprintf( globals.outputFile, "    [ %u ] = k%s%s,\n",
+                         i, globals.prefix, set->parsed[ accept[ i ] - 1 ].keyword );
+                accepting = true;
+            }
+        }
+        if ( !accepting )
+        {
+            fprintf( globals.outputFile, "    k%sUnset\n", globals.prefix );
+        }
+        fprintf( globals.outputFile, "};\n\n" );
+
+        fprintf( globals.outputFile,
+                 "tTrie map%sTrie = { map%sTrieClass, map%sTrieNode, map%sTrieAccept };\n\n"
+                 "static inline t%sIndex lookup%sString( const char * string, size_t length )\n"
+                 "{\n"
+                 "    return (t%sIndex)matchTrie( &map%sTrie, string, length );\n"
+                 "}\n"
+                 "\n",
+                 globals.prefix, globals.prefix, globals.prefix, globals.prefix,
+                 globals.prefix, globals.prefix, globals.prefix, globals.prefix );
+    }
+
+    free( trie );
+    free( queue );
+    free( base );
+    free( check );
+    free( accept );
+    free( used );
+
+    return result;
+}
+
+int compareByIndex( const void * a, const void * b )
+{
+    const tRecord * recordA = *(const tRecord **)a;
+    const tRecord * recordB = *(const tRecord **)b;
+
+    if ( recordA->index != recordB->index )
+    {
+        return recordA->index < recordB->index ? -1 : 1;
+    }
+    return recordA->hash < recordB->hash ? -1 : ( recordA->hash > recordB->hash );
+}
+
+/*
+ * Rather than a table to be searched at run time, emit a switch on the hash
+ * constants, and let the compiler choose how best to find the matching case
+ * (a jump table, a tree of comparisons against immediates, etc.) and inline
+ * it into the callers. The aliases of each keyword share its return.
+ */
+int emitCode( tKeywordSet * set )
+{
+    int result = 0;
+    unsigned int i;
+
+    tRecord ** byIndex = calloc( set->count, sizeof( tRecord * ));
+    if ( byIndex == NULL)
+    {
+        printError( "failed to allocate memory" );
+        result = -1;
+    }
+    else
+    {
+        memcpy( byIndex, set->sorted, set->count * sizeof( tRecord * ));
+        qsort( byIndex, set->count, sizeof( tRecord * ), compareByIndex );
+
+        fprintf( globals.outputFile,
+                 "/* pre-computed lookup */\n"
+                 "\n"
+                 "static inline t%sIndex lookup%sHash( %s hash )\n"
+                 "{\n",
+                 globals.prefix, globals.prefix, hashType() );
+
+        if ( globals.filterProbes != 0 )
+        {
+            fprintf( globals.outputFile,
+                     "    if ( !mayContainHash( &map%sFilter, hash ))\n"
+                     "    {\n"
+                     "        return k%sUnset;\n"
+                     "    }\n"
+                     "\n",
+                     globals.prefix, globals.prefix );
+        }
+
+        fprintf( globals.outputFile,
+                 "    switch ( hash )\n"
+                 "    {\n" );
+
+        for ( i = 0; i < set->count; i++ )
+        {
+            fprintf( globals.outputFile, "    case %s:  /* \"%s\" */\n",
+                     hashLiteral( byIndex[ i ]->hash ), byIndex[ i ]->hashedString );
+
+            if ( i == set->count - 1 || byIndex[ i + 1 ]->index != byIndex[ i ]->index )
+            {
+                fprintf( globals.outputFile, "        return k%s%s;\n\n",
+                         globals.prefix, set->parsed[ byIndex[ i ]->index ].keyword );
+            }
+        }
+
+        fprintf( globals.outputFile,
+                 "    default:\n"
+                 "        return k%sUnset;\n"
+                 "    }\n"
+                 "}\n"
+                 "\n",
+                 globals.prefix );
+
+        free( byIndex );
+    }
+    return result;
+}
+
+/*
+ * Try to place every key with the given seed. Buckets are placed largest first, while
+ * the table is still mostly empty; each tries successive displacements until all its
+ * keys land in distinct, unoccupied slots. Returns false if some bucket can't be placed.
+ */
+bool buildPerfect( tKeywordSet * set,
+                   tHash seed,
+                   uint32_t buckets,
+                   uint32_t * displace,
+                   tRecord ** slots )
+{
+    bool          result  = true;
+    uint32_t      count   = set->count;
+    uint32_t    * bucket  = calloc( count, sizeof( uint32_t ));
+    uint32_t    * size    = calloc( buckets, sizeof( uint32_t ));
+    uint32_t    * members = calloc( count, sizeof( uint32_t ));
+    uint32_t    * start   = calloc( buckets + 1, sizeof( uint32_t ));
+    uint32_t    * trial   = calloc( count, sizeof( uint32_t ));
+    uint32_t      maxSize = 0;
+    uint64_t      maxTries = 32 * (uint64_t)count + 1024;
+
+    if ( bucket == NULL || size == NULL || members == NULL || start == NULL || trial == NULL)
+    {
+        printError( "failed to allocate memory" );
+        result = false;
+    }
+    else
+    {
+        uint32_t i, j, k;
+
+        memset( slots, 0, count * sizeof( tRecord * ));
+
+        /* bucket the keys (a counting sort, so each bucket's members are contiguous) */
+        for ( i = 0; i < count; i++ )
+        {
+            bucket[ i ] = perfectBucket( perfectMix( set->sorted[ i ]->hash, seed ), buckets );
+            size[ bucket[ i ] ]++;
+        }
+        for ( i = 0; i < buckets; i++ )
+        {
+            start[ i + 1 ] = start[ i ] + size[ i ];
+            if ( maxSize < size[ i ] ) { maxSize = size[ i ]; }
+            displace[ i ] = 0;
+        }
+        for ( i = 0; i < count; i++ )
+        {
+            members[ start[ bucket[ i ] ]++ ] = i;
+        }
+        for ( i = 0; i < buckets; i++ )
+        {
+            start[ i ] -= size[ i ];
+        }
+
+        for ( uint32_t n = maxSize; n > 0 && result; n-- )
+        {
+            for ( i = 0; i < buckets && result; i++ )
+            {
+                if ( size[ i ] != n ) continue;
+
+                uint64_t d;
+                for ( d = 0; d < maxTries; d++ )
+                {
+                    for ( j = 0; j < n; j++ )
+                    {
+                        tHash mixed = perfectMix( set->sorted[ members[ start[ i ] + j ]]->hash, seed );
+                        trial[ j ] = perfectSlot( mixed, (uint32_t)d, count );
+                        if ( slots[ trial[ j ]] != NULL ) break;
+                        for ( k = 0; k < j && trial[ k ] != trial[ j ]; k++ ) { }
+                        if ( k < j ) break;
+                    }
+                    if ( j == n ) break;
+                }
+
+                if ( d == maxTries )
+                {
+                    result = false;
+                }
+                else
+                {
+                    displace[ i ] = (uint32_t)d;
+                    for ( j = 0; j < n; j++ )
+                    {
+                        slots[ trial[ j ]] = set->sorted[ members[ start[ i ] + j ]];
+                    }
+                }
+            }
+        }
+    }
+
+    free( bucket );
+    free( size );
+    free( members );
+    free( start );
+    free( trial );
+
+    return result;
+}
+
+int emitPerfect( tKeywordSet * set )
+{
+    int result = 0;
+    unsigned int i;
+    unsigned int attempt;
+    tHash seed = 0;
+    char * call;
+
+    uint32_t   buckets  = ( set->count + kPerfectBucketSize - 1 ) / kPerfectBucketSize;
+    uint32_t * displace = calloc( buckets, sizeof( uint32_t ));
+    tRecord ** slots    = calloc( set->count, sizeof( tRecord * ));
+
+    if ( displace == NULL || slots == NULL)
+    {
+        printError( "failed to allocate memory" );
+        result = -1;
+    }
+    else
+    {
+        for ( attempt = 0; attempt < kPerfectMaxSeeds; attempt++ )
+        {
+            seed = 0x9e3779b97f4a7c15ULL * ( attempt + 1 );
+            if ( buildPerfect( set, seed, buckets, displace, slots ))
+            {
+                break;
+            }
+        }
+
+        if ( attempt == kPerfectMaxSeeds )
+        {
+            printError( "unable to construct a perfect hash for the %u %s keywords after %u attempts",
+                        set->count, globals.prefix, kPerfectMaxSeeds );
+            result = -1;
+        }
+        else
+        {
+            fprintf( globals.outputFile, kPerfectPrefix, globals.prefix );
+            for ( i = 0; i < buckets; i++ )
+            {
+                fprintf( globals.outputFile, "%s%u%s",
+                         ( i % 8 ) == 0 ? "    " : " ",
+                         displace[ i ],
+                         ( i < buckets - 1 ) ? (( i % 8 ) == 7 ? ",\n" : "," ) : "\n" );
+            }
+            fprintf( globals.outputFile, "};\n\n" );
+
+            fprintf( globals.outputFile, "tSlot map%sPerfectSlot[] = {\n", globals.prefix );
+            for ( i = 0; i < set->count; i++ )
+            {
+                fprintf( globals.outputFile, "    { 0x%016lx, k%s%s }%c%*c/* \"%s\" */\n",
+                         slots[ i ]->hash,
+                         globals.prefix, set->parsed[ slots[ i ]->index ].keyword,
+                         ( i < set->count - 1 ) ? ',' : ' ',
+                         (int)( strlen( set->parsed[ slots[ i ]->index ].keyword ) - set->maxKeywordLen - 1 ), ' ',
+                         slots[ i ]->hashedString );
+            }
+            fprintf( globals.outputFile, "};\n\n" );
+
+            fprintf( globals.outputFile,
+                     "tPerfectHash map%sPerfect = {\n"
+                     "    0x%016lx, %u, %u,\n"
+                     "    map%sPerfectDisplace,\n"
+                     "    map%sPerfectSlot\n"
+                     "};\n\n",
+                     globals.prefix, seed, buckets, set->count, globals.prefix, globals.prefix );
+
+            asprintf( &call, "findHashPerfect( &map%sPerfect, hash )", globals.prefix );
+            printLookupFunction( call );
+            free( call );
+        }
+    }
+
+    free( displace );
+    free( slots );
+
+    return result;
+}
+
+int compareHashes( const void * a, const void * b )
+{
+    tHash hashA = *(const tHash *)a;
+    tHash hashB = *(const tHash *)b;
+
+    return hashA < hashB ? -1 : ( hashA > hashB );
+}
+
+/*
+ * a blocked Bloom filter over the hashes (a single probe makes it a plain bitmap),
+ * sized from the number of hashes. Its false positive rate is measured by probing
+ * it with pseudo-random hashes that are not in the set.
+ */
+int emitFilter( tKeywordSet * set )
+{
+    int result = 0;
+    unsigned int i;
+
+    uint32_t   blocks = ( set->count * globals.filterBitsPerKey + kFilterBlockBits - 1 ) / kFilterBlockBits;
+    uint32_t   words  = blocks * ( kFilterBlockBits / 64 );
+    uint64_t * bits   = calloc( words, sizeof( uint64_t ));
+    tHash    * hashes = calloc( set->count, sizeof( tHash ));
+
+    if ( bits == NULL || hashes == NULL)
+    {
+        printError( "failed to allocate memory" );
+        result = -1;
+    }
+    else
+    {
+        tFilter filter = { blocks, globals.filterProbes, bits };
+
+        for ( i = 0; i < set->count; i++ )
+        {
+            tHash mixed = perfectMix( set->sorted[ i ]->hash, kFilterSeed );
+            uint64_t * block = &bits[ filterBlock( mixed, blocks ) * ( kFilterBlockBits / 64 ) ];
+
+            for ( uint32_t probe = 0; probe < globals.filterProbes; probe++ )
+            {
+                uint32_t bit = filterBit( mixed, probe );
+                block[ bit / 64 ] |= 1ULL << ( bit % 64 );
+            }
+            hashes[ i ] = set->sorted[ i ]->hash;
+        }
+
+        unsigned int trials = 0;
+        unsigned int falsePositives = 0;
+        tHash        random = 0;
+        while ( trials < kFilterTrials )
+        {
+            random += 0x9e3779b97f4a7c15ULL;    /* splitmix64 */
+            tHash probe = perfectMix( random, 0 );
+            if ( bsearch( &probe, hashes, set->count, sizeof( tHash ), compareHashes ) == NULL)
+            {
+                trials++;
+                falsePositives += mayContainHash( &filter, probe );
+            }
+        }
+        double rate = ( 100.0 * falsePositives ) / trials;
+
+        fprintf( stderr, "filter: %u bytes, %u probes, %.3f%% false positives\n",
+                 words * 8, globals.filterProbes, rate );
+
+        fprintf( globals.outputFile, kFilterPrefix,
+                 globals.filterProbes, globals.filterBitsPerKey, rate, globals.prefix );
+        for ( i = 0; i < words; i++ )
+        {
+            fprintf( globals.outputFile, "%s0x%016lx%s",
+                     ( i % 4 ) == 0 ? "    " : " ",
+                     bits[ i ],
+                     ( i < words - 1 ) ? (( i % 4 ) == 3 ? ",\n" : "," ) : "\n" );
+        }
+        fprintf( globals.outputFile, "};\n\n" );
+
+        fprintf( globals.outputFile,
+                 "tFilter map%sFilter = { %u, %u, map%sFilterBits };\n\n",
+                 globals.prefix, blocks, globals.filterProbes, globals.prefix );
+    }
+
+    free( bits );
+    free( hashes );
+
+    return result;
+}
+
+/* a string as a C literal, with anything unusual as an octal escape */
+void printLiteral( const char * string, size_t length )
+{
+    fputc( '\"', globals.outputFile );
+    for ( size_t i = 0; i < length; i++ )
+    {
+        unsigned char c = string[ i ];
+        if ( c == '\"' || c == '\\' || !isprint( c ) || ( c == '?' && i + 1 < length && string[ i + 1 ] == '?' ))
+        {
+            fprintf( globals.outputFile, "\\%03o", c );
+        }
+        else
+        {
+            fputc( c, globals.outputFile );
+        }
+    }
+    fputc( '\"', globals.outputFile );
+}
+
+/*
+ * the strings hashed for each keyword, so a match can be confirmed by comparing them,
+ * as mapped, with the input. Each is preceded by its length, and each keyword's strings
+ * end at its offset - emitted regardless of layout, as it is indexed by keyword.
+ */
+int emitPool( tKeywordSet * set )
+{
+    int result = 0;
+    unsigned int i;
+    uint32_t offset = 0;
+
+    uint32_t * offsets = calloc( set->keywordCount + 1, sizeof( uint32_t ));
+    if ( offsets == NULL)
+    {
+        printError( "failed to allocate memory" );
+        return -1;
+    }
+
+    fprintf( globals.outputFile,
+             "/* the hashed strings of each keyword, to confirm a match */\n"
+             "\n"
+             "const char map%sPoolBytes[] =\n",
+             globals.prefix );
+
+    for ( i = 0; i < set->keywordCount && result == 0; i++ )
+    {
+        const char * src = set->parsed[ i ].hashed;
+
+        fprintf( globals.outputFile, "    /* k%s%*s */",
+                 globals.prefix, -set->maxKeywordLen, set->parsed[ i ].keyword );
+        while ( *src != '\0' )
+        {
+            size_t length = strcspn( src, "," );
+            if ( length > 255 )
+            {
+                printError( "\"%.*s\" is too long to verify (255 characters at most)", (int)length, src );
+                result = -1;
+                break;
+            }
+            fprintf( globals.outputFile, " \"\\%03o\" ", (unsigned int)length );
+            printLiteral( src, length );
+            offset += 1 + length;
+
+            src += length;
+            if ( *src != '\0' ) { ++src; }
+        }
+        fputc( '\n', globals.outputFile );
+        offsets[ i + 1 ] = offset;
+    }
+    fprintf( globals.outputFile, "    ;\n\n" );
+
+    fprintf( globals.outputFile, "uint32_t map%sPoolOffset[] = {\n", globals.prefix );
+    for ( i = 0; i <= set->keywordCount; i++ )
+    {
+        fprintf( globals.outputFile, "%s%u%s",
+                 ( i % 8 ) == 0 ? "    " : " ",
+                 offsets[ i ],
+                 ( i < set->keywordCount ) ? (( i % 8 ) == 7 ? ",\n" : "," ) : "\n" );
+    }
+    fprintf( globals.outputFile, "};\n\n" );
+
+    fprintf( globals.outputFile,
+             "tStringPool map%sPool = { map%sPoolOffset, map%sPoolBytes };\n\n",
+             globals.prefix, globals.prefix, globals.prefix );
+
+    free( offsets );
+
+    return result;
+}
+
+typedef struct
+{
+    uint32_t  cell;
+    tHash     hash;
+    tRecord * record;
+} tDispatchEntry;
+
+int compareDispatchEntries( const void * a, const void * b )
+{
+    const tDispatchEntry * entryA = a;
+    const tDispatchEntry * entryB = b;
+
+    if ( entryA->cell != entryB->cell )
+    {
+        return entryA->cell < entryB->cell ? -1 : 1;
+    }
+    return entryA->hash < entryB->hash ? -1 : ( entryA->hash > entryB->hash );
+}
+
+/*
+ * A dispatch table, keyed on the length and the (mapped) first character of each
+ * hashed string. Every byte is mapped to a single character, so the mapped length
+ * is the length of the string. Each cell has its own sorted sub-table of full
+ * 64-bit hashes, whatever the width of the main table, so the lookup that uses
+ * it never needs to consult the main table.
+ */
+int emitDispatch( tKeywordSet * set )
+{
+    int result = 0;
+    unsigned int i;
+    uint16_t     label[ 512 ] = { 0 };
+    uint16_t     class[ 256 ];
+    uint32_t     classes = 1;
+    uint32_t     maxLength = 0;
+
+    /* C has no empty initializers, so an empty table can't be emitted */
+    if ( set->count == 0 )
+    {
+        printError( "the %s dispatch table has no strings to match", globals.prefix );
+        return -1;
+    }
+
+    for ( i = 0; i < set->count; i++ )
+    {
+        const char * hashedString = set->sorted[ i ]->hashedString;
+        if ( hashedString[ 0 ] != '\0' )
+        {
+            tMappedChar c = remapChar( gCharMap, hashedString[ 0 ] );
+            if ( label[ c ] == 0 )
+            {
+                label[ c ] = classes++;
+            }
+            maxLength = max( maxLength, strlen( hashedString ));
+        }
+        else
+        {
+            printError( "k%s%s has an empty string, which a dispatch table can't match",
+                        globals.prefix, set->parsed[ set->sorted[ i ]->index ].keyword );
+            result = -1;
+        }
+    }
+    if ( result != 0 )
+    {
+        return result;
+    }
+    for ( i = 0; i < 256; i++ )
+    {
+        class[ i ] = label[ remapChar( gCharMap, i ) ];
+    }
+
+    uint32_t lengths = (( maxLength < kDispatchLengths ) ? maxLength : kDispatchLengths - 1 ) + 1;
+    uint32_t cells   = lengths * classes;
+
+    tDispatchEntry * entry  = calloc( set->count, sizeof( tDispatchEntry ));
+    uint32_t       * offset = calloc( cells + 1, sizeof( uint32_t ));
+    if ( entry == NULL || offset == NULL)
+    {
+        printError( "failed to allocate memory" );
+        free( entry );
+        free( offset );
+        return -1;
+    }
+
+    uint32_t count = 0;
+    for ( i = 0; i < set->count; i++ )
+    {
+        const char * hashedString = set->sorted[ i ]->hashedString;
+        size_t length = strlen( hashedString );
+        if ( length > 0 )
+        {
+            uint32_t bucket = ( length < lengths ) ? length : lengths - 1;
+            entry[ count ].cell   = bucket * classes + class[ (unsigned char)hashedString[ 0 ] ];
+            /* the record's own hash may have been narrowed */
+            entry[ count ].hash   = hashKeyword( globals.seed, hashedString, length );
+            entry[ count ].record = set->sorted[ i ];
+            offset[ entry[ count ].cell + 1 ]++;
+            count++;
+        }
+    }
+    qsort( entry, count, sizeof( tDispatchEntry ), compareDispatchEntries );
+    for ( i = 0; i < cells; i++ )
+    {
+        offset[ i + 1 ] += offset[ i ];
+    }
+
+    fprintf( globals.outputFile,
+             "/* pre-computed dispatch table, %u length buckets by %u first-character classes */\n"
+             "\n"
+             "uint16_t map%sDispatchClass[256] = {\n",
+             lengths, classes, globals.prefix );
+    for ( i = 0; i < 256; i++ )
+    {
+        fprintf( globals.outputFile, "%s%3u%s",
+                 ( i % 16 ) == 0 ? "    " : " ",
+                 class[ i ],
+                 ( i < 255 ) ? (( i % 16 ) == 15 ? ",\n" : "," ) : "\n" );
+    }
+    fprintf( globals.outputFile, "};\n\n" );
+
+    fprintf( globals.outputFile, "uint32_t map%sDispatchOffset[] = {\n", globals.prefix );
+    for ( i = 0; i <= cells; i++ )
+    {
+        fprintf( globals.outputFile, "%s%u%s",
+                 ( i % 8 ) == 0 ? "    " : " ",
+                 offset[ i ],
+                 ( i < cells ) ? (( i % 8 ) == 7 ? ",\n" : "," ) : "\n" );
+    }
+    fprintf( globals.outputFile, "};\n\n" );
+
+    fprintf( globals.outputFile, "tHash map%sDispatchHash[] = {\n", globals.prefix );
+    for ( i = 0; i < count; i++ )
+    {
+        fprintf( globals.outputFile, "    0x%016lx%c  /* \"%s\" */\n",
+                 entry[ i ].hash,
+                 ( i < count - 1 ) ? ',' : ' ',
+                 entry[ i ].record->hashedString );
+    }
+    fprintf( globals.outputFile, "};\n\n" );
+
+    fprintf( globals.outputFile, "tIndex map%sDispatchIndex[] = {\n", globals.prefix );
+    for ( i = 0; i < count; i++ )
+    {
+        fprintf( globals.outputFile, "    k%s%s%c\n",
+                 globals.prefix, set->parsed[ entry[ i ].record->index ].keyword,
+                 ( i < count - 1 ) ? ',' : ' ' );
+    }
+    fprintf( globals.outputFile, "};\n\n" );
+
+    fprintf( globals.outputFile,
+             "tDispatch map%sDispatch = { %u, %u, %u, map%sDispatchClass, map%sDispatchOffset,\n"
+             "                           map%sDispatchHash, map%sDispatchIndex, %s, k%sHashSeed, %s%s%s };\n\n",
+             globals.prefix, maxLength, lengths, classes, globals.prefix, globals.prefix,
+             globals.prefix, globals.prefix, hashFunctionName(), globals.prefix,
+             ( globals.hashFunction == kHashWord ) ? "&g" : "NULL",
+             ( globals.hashFunction == kHashWord ) ? globals.prefix : "",
+             ( globals.hashFunction == kHashWord ) ? "WordMap" : "" );
+
+    fprintf( globals.outputFile,
+             "static inline t%sIndex lookup%sDispatch( const char * string, size_t length )\n"
+             "{\n",
+             globals.prefix, globals.prefix );
+    if ( globals.emitPool && globals.emit != kEmitTrie )
+    {
+        fprintf( globals.outputFile,
+                 "    t%sIndex index = (t%sIndex)findHashDispatch( &map%sDispatch, g%sCharMap, string, length );\n"
+                 "\n"
+                 "    return verifyMatch( &map%sPool, g%sCharMap, index, string, length ) ? index : k%sUnset;\n",
+                 globals.prefix, globals.prefix, globals.prefix, globals.prefix,
+                 globals.prefix, globals.prefix, globals.prefix );
+    }
+    else
+    {
+        fprintf( globals.outputFile,
+                 "    return (t%sIndex)findHashDispatch( &map%sDispatch, g%sCharMap, string, length );\n",
+                 globals.prefix, globals.prefix, globals.prefix );
+    }
+    fprintf( globals.outputFile, "}\n\n" );
+
+    free( entry );
+    free( offset );
+
+    return result;
+}
+
+/* hash the string, look it up, and only believe a match if its string matches too */
+void printVerifiedLookupFunction( void )
+{
+    fprintf( globals.outputFile,
+             "static inline t%sIndex lookup%sString( const char * string, size_t length )\n"
+             "{\n"
+             "    t%sIndex index = lookup%sHash( %shash%sN( string, length )%s );\n"
+             "\n"
+             "    return verifyMatch( &map%sPool, g%sCharMap, index, string, length ) ? index : k%sUnset;\n"
+             "}\n"
+             "\n",
+             globals.prefix, globals.prefix,
+             globals.prefix, globals.prefix,
+             ( globals.hashBits == 32 ) ? "narrowHash( " : "", globals.prefix,
+             ( globals.hashBits == 32 ) ? " )" : "",
+             globals.prefix, globals.prefix, globals.prefix );
+}
+
+/*
+ * for C++, a literal suffix that hashes a string at compile time, as the lookup expects
+ * it (narrowed, for a 32-bit table). A constexpr copy of the character map is needed,
+ * as the one above can't be read at compile time
+ */
+void printHashLiteral( void )
+{
+    fprintf( globals.outputFile,
+             "#if defined( __cplusplus ) && __cplusplus >= 201703L\n"
+             "#include \"libhashstrings.hpp\"\n"
+             "\n"
+             "constexpr tCharMap g%sCharMapConst[] = {\n",
+             globals.prefix );
+    for ( int i = 0; i < (( 256 / ( 64 / 9 )) + 1 ); i++ )
+    {
+        fprintf( globals.outputFile, "%s0x%016lx%s",
+                 ( i % 4 ) == 0 ? "    " : " ",
+                 gCharMap[ i ],
+                 ( i < ( 256 / ( 64 / 9 ))) ? (( i % 4 ) == 3 ? ",\n" : "," ) : "\n" );
+    }
+    fprintf( globals.outputFile, "};\n\n" );
+
+    fprintf( globals.outputFile,
+             "constexpr %s operator\"\"_hs%s( const char * string, std::size_t length )\n"
+             "{\n"
+             "    return %shashstrings::hashStringWith( %s, k%sHashSeed, string, length, g%sCharMapConst )%s;\n"
+             "}\n"
+             "#endif\n"
+             "\n",
+             hashType(), globals.prefix,
+             ( globals.hashBits == 32 ) ? "hashstrings::narrowHash( " : "",
+             hashFunctionName(), globals.prefix, globals.prefix,
+             ( globals.hashBits == 32 ) ? " )" : "" );
+}
+
+/* the character map folded to a byte per byte, and its runs, for the word hash */
+void printWordMap( void )
+{
+    fprintf( globals.outputFile, "tWordMap g%sWordMap = {\n    {\n", globals.prefix );
+    for ( unsigned int i = 0; i < 256; i++ )
+    {
+        fprintf( globals.outputFile, "%s0x%02x%s",
+                 ( i % 8 ) == 0 ? "        " : " ",
+                 gWordMap.fold[ i ],
+                 ( i < 255 ) ? (( i % 8 ) == 7 ? ",\n" : "," ) : "\n" );
+    }
+    fprintf( globals.outputFile, "    },\n    %u,\n    {", gWordMap.ranges );
+    for ( unsigned int i = 0; i < kWordRanges; i++ )
+    {
+        const tWordRange * range = &gWordMap.range[ i ];
+        fprintf( globals.outputFile, "%s{ 0x%02x, 0x%02x, 0x%02x, 0x%02x }",
+                 ( i == 0 ) ? " " : ", ",
+                 range->first, range->last, range->subtract, range->value );
+    }
+    fprintf( globals.outputFile, " }\n};\n\n" );
+}
+
+/*
+ * the dictionary's own hash functions, with its hash function and seed built in.
+ * The seed isn't known until the keywords have been hashed, so these come after
+ * the character map, just before the first lookup that uses them
+ */
+void printHashFunctions( void )
+{
+    /* the lookups need the character map, even if there are no mappings */
+    if ( !globals.charMapEmitted )
+    {
+        printMap();
+    }
+
+    fprintf( globals.outputFile, "#define k%sHashSeed 0x%016lxULL\n\n", globals.prefix, globals.seed );
+
+    /* the word hash has a map of its own, the flat map is only for the legacy hash, unseeded */
+    if ( globals.hashFunction == kHashWord )
+    {
+        printWordMap();
+        fprintf( globals.outputFile,
+                 "static inline tHash hash%sString( const char * string )\n"
+                 "{\n"
+                 "    return hashStringWord( &g%sWordMap, k%sHashSeed, string, strlen( string ));\n"
+                 "}\n"
+                 "\n"
+                 "static inline tHash hash%sN( const char * string, size_t length )\n"
+                 "{\n"
+                 "    return hashStringWord( &g%sWordMap, k%sHashSeed, string, length );\n"
+                 "}\n"
+                 "\n",
+                 globals.prefix, globals.prefix, globals.prefix,
+                 globals.prefix, globals.prefix, globals.prefix );
+        printHashLiteral();
+        return;
+    }
+
+    if ( globals.hashFunction == kHashLegacy && globals.seed == 0 )
+    {
+        fprintf( globals.outputFile,
+                 "static inline tHash hash%sString( const char * string )\n"
+                 "{\n"
+                 "    return hashStringFlat%s( string, g%sCharMapFlat );\n"
+                 "}\n"
+                 "\n",
+                 globals.prefix, globals.charMapWide ? "" : "8", globals.prefix );
+    }
+    else
+    {
+        fprintf( globals.outputFile,
+                 "static inline tHash hash%sString( const char * string )\n"
+                 "{\n"
+                 "    return hashStringWith( %s, k%sHashSeed, string, strlen( string ), g%sCharMap );\n"
+                 "}\n"
+                 "\n",
+                 globals.prefix, hashFunctionName(), globals.prefix, globals.prefix );
+    }
+
+    fprintf( globals.outputFile,
+             "static inline tHash hash%sN( const char * string, size_t length )\n"
+             "{\n"
+             "    return hashStringWith( %s, k%sHashSeed, string, length, g%sCharMap );\n"
+             "}\n"
+             "\n",
+             globals.prefix, hashFunctionName(), globals.prefix, globals.prefix );
+
+    printHashLiteral();
+}
+
+/*
+ * classify a token in place, given as a pointer and a length. With 'verify', or for
+ * the trie, that's what lookup<Prefix>String() already does, and this is a synonym
+ */
+void printLengthLookupFunction( void )
+{
+    fprintf( globals.outputFile,
+             "static inline t%sIndex lookup%sN( const char * string, size_t length )\n"
+             "{\n",
+             globals.prefix, globals.prefix );
+    if ( globals.emitPool || globals.emit == kEmitTrie )
+    {
+        fprintf( globals.outputFile,
+                 "    return lookup%sString( string, length );\n",
+                 globals.prefix );
+    }
+    else
+    {
+        fprintf( globals.outputFile,
+                 "    return lookup%sHash( %shash%sN( string, length )%s );\n",
+                 globals.prefix,
+                 ( globals.hashBits == 32 ) ? "narrowHash( " : "", globals.prefix,
+                 ( globals.hashBits == 32 ) ? " )" : "" );
+    }
+    fprintf( globals.outputFile, "}\n\n" );
+}
+
+int emitSearchTable( tKeywordSet * set )
+{
+    int result = 0;
+
+    printHashFunctions();
+
+    /* with no layout asked for, a small enough dictionary is scanned whole */
+    if ( globals.emitDefault && set->count <= kScanMaximum )
+    {
+        globals.emit = kEmitScan;
+    }
+    else if ( globals.emitDefault && globals.hashBits == 32 )
+    {
+        /* the check in processStructure() had to wait until the size was known */
+        printError( "hashBits = 32 with more than %u strings needs emit = eytzinger, split or code",
+                    kScanMaximum );
+        return -1;
+    }
+
+    if ( globals.filterProbes != 0 )
+    {
+        result = emitFilter( set );
+        if ( result != 0 )
+        {
+            return result;
+        }
+    }
+
+    switch ( globals.emit )
+    {
+    case kEmitEytzinger:
+        result = emitEytzinger( set );
+        break;
+
+    case kEmitPerfect:
+        result = emitPerfect( set );
+        break;
+
+    case kEmitSplit:
+        result = emitSplit( set );
+        break;
+
+    case kEmitSTree:
+        result = emitSTree( set );
+        break;
+
+    case kEmitCode:
+        result = emitCode( set );
+        break;
+
+    case kEmitRadix:
+        result = emitRadix( set );
+        break;
+
+    case kEmitSwiss:
+        result = emitSwiss( set );
+        break;
+
+    case kEmitTrie:
+        result = emitTrie( set );
+        break;
+
+    case kEmitComplete:
+        result = emitComplete( set );
+        break;
+
+    case kEmitScan:
+        /* when chosen for its size, map<Prefix>Search[] is still there for findHash() -
+         * which only takes 64-bit hashes */
+        if ( globals.emitDefault && globals.hashBits == 64 )
+        {
+            result = printSearchTree( set );
+        }
+        if ( result == 0 )
+        {
+            result = emitScan( set );
+        }
+        break;
+
+    case kEmitTree:
+    default:
+        result = emitTree( set );
+        break;
+    }
+
+    /* the trie compares every character, so it has nothing to verify */
+    if ( result == 0 && globals.emitPool && globals.emit != kEmitTrie )
+    {
+        result = emitPool( set );
+        if ( result == 0 )
+        {
+            printVerifiedLookupFunction();
+        }
+    }
+
+    if ( result == 0 )
+    {
+        printLengthLookupFunction();
+    }
+
+    if ( result == 0 && globals.emitDispatch )
+    {
+        result = emitDispatch( set );
+    }
+
+    return result;
+}
+
+typedef struct
+{
+    tHash        hash;
+    unsigned int index;
+    const char * string;
+    size_t       length;
+} tSeedTrial;
+
+int compareSeedTrials( const void * a, const void * b )
+{
+    const tSeedTrial * trialA = a;
+    const tSeedTrial * trialB = b;
+
+    if ( trialA->hash != trialB->hash )
+    {
+        return trialA->hash < trialB->hash ? -1 : 1;
+    }
+    return trialA->index < trialB->index ? -1 : ( trialA->index > trialB->index );
+}
+
+/* true if the two strings are the same once mapped, so they'll collide whatever the seed */
+bool sameMapping( const char * stringA, size_t lengthA, const char * stringB, size_t lengthB )
+{
+    if ( lengthA != lengthB )
+    {
+        return false;
+    }
+    for ( size_t i = 0; i < lengthA; i++ )
+    {
+        if ( remapChar( gCharMap, stringA[ i ] ) != remapChar( gCharMap, stringB[ i ] ))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * the number of pairs of strings of different keywords that have the same hash with
+ * this seed, and that some other seed might separate. *hopeless is set to the number
+ * of pairs that are the same string once they're mapped, which are only reported if
+ * asked to be - they'll be there for every seed.
+ */
+unsigned int countCollisions( tSeedTrial * trial,
+                              tParsedArray * parsed,
+                              unsigned int keywordCount,
+                              tHash seed,
+                              bool report,
+                              unsigned int * hopeless )
+{
+    unsigned int i;
+    unsigned int count = 0;
+    unsigned int collisions = 0;
+
+    *hopeless = 0;
+
+    for ( i = 0; i < keywordCount; i++ )
+    {
+        const char * src = parsed[ i ].hashed;
+        while ( *src != '\0' )
+        {
+            size_t length = strcspn( src, "," );
+            tHash hash = hashKeyword( seed, src, length );
+
+            trial[ count ].hash   = ( globals.hashBits == 32 ) ? narrowHash( hash ) : hash;
+            trial[ count ].index  = i;
+            trial[ count ].string = src;
+            trial[ count ].length = length;
+            count++;
+
+            src += length;
+            if ( *src != '\0' ) { ++src; }
+        }
+    }
+
+    qsort( trial, count, sizeof( tSeedTrial ), compareSeedTrials );
+    for ( i = 1; i < count; i++ )
+    {
+        if ( trial[ i ].hash == trial[ i - 1 ].hash && trial[ i ].index != trial[ i - 1 ].index )
+        {
+            if ( !sameMapping( trial[ i - 1 ].string, trial[ i - 1 ].length, trial[ i ].string, trial[ i ].length ))
+            {
+                collisions++;
+            }
+            else
+            {
+                if ( report )
+                {
+                    printError( "\"%.*s\" (k%s%s) and \"%.*s\" (k%s%s) map to the same characters, so no seed can separate them",
+                                (int)trial[ i - 1 ].length, trial[ i - 1 ].string,
+                                globals.prefix, parsed[ trial[ i - 1 ].index ].keyword,
+                                (int)trial[ i ].length, trial[ i ].string,
+                                globals.prefix, parsed[ trial[ i ].index ].keyword );
+                }
+                ( *hopeless )++;
+            }
+        }
+    }
+    return collisions;
+}
+
+/*
+ * Try the seed in the file (zero, if there isn't one) and then up to seedSearch - 1 others,
+ * until the hashes of the keywords are all distinct at the width of the table. Once they
+ * are, any of the layouts - perfect included - can be built from them.
+ *
+ * Strings that map to the same characters collide whatever the seed. At 32 bits that's
+ * fatal, as any other collision would be; at 64 bits they're reported, and the search
+ * carries on for a seed that separates the rest - as before, the later string is lost.
+ */
+int searchSeed( tParsedArray * parsed, unsigned int keywordCount )
+{
+    int result = 0;
+    unsigned int i;
+    unsigned int strings = 0;
+
+    for ( i = 0; i < keywordCount; i++ )
+    {
+        for ( const char * src = parsed[ i ].hashed; *src != '\0'; src++ )
+        {
+            strings += ( *src == ',' );
+        }
+        strings++;
+    }
+
+    tSeedTrial * trial = calloc( strings, sizeof( tSeedTrial ));
+    if ( trial == NULL)
+    {
+        printError( "failed to allocate memory" );
+        return -1;
+    }
+
+    tHash seed = globals.seed;
+    unsigned int hopeless = 0;
+    unsigned int attempt;
+    for ( attempt = 0; attempt < globals.seedSearch; attempt++ )
+    {
+        if ( countCollisions( trial, parsed, keywordCount, seed, attempt == 0, &hopeless ) == 0 )
+        {
+            break;
+        }
+        if ( hopeless > 0 && globals.hashBits == 32 )
+        {
+            break;
+        }
+        seed = perfectMix( attempt + 1, kSeedSearchSeed );
+    }
+
+    if ( hopeless > 0 && globals.hashBits == 32 )
+    {
+        printError( "the %s keywords can't be collision-free at 32 bits, whatever the seed", globals.prefix );
+        result = -1;
+    }
+    else if ( attempt == globals.seedSearch )
+    {
+        printError( "no seed in %u attempts makes the %s keywords collision-free at %d bits",
+                    globals.seedSearch, globals.prefix, globals.hashBits );
+        result = -1;
+    }
+    else
+    {
+        fprintf( stderr, "seed: 0x%016lx, after %u attempt%s\n", seed, attempt + 1, ( attempt == 0 ) ? "" : "s" );
+        globals.seed = seed;
+    }
+
+    free( trial );
+
+    return result;
+}
+
+int processKeywords( config_t * config )
+{
+    int result = 0;
+    config_setting_t * keywords;
+
+    unsigned int keywordCount;
+
+    keywords = config_lookup( config, "keywords" );
+    if ( keywords == NULL || !config_setting_is_array( keywords ))
+    {
+        printError( "\'keywords\' must be a array, in file \"%s\" at line %d",
+                    config_setting_source_file( keywords ),
+                    config_setting_source_line( keywords ));
+    }
+    else
+    {
+        config_setting_t * element;
+        unsigned int i = 0;
+
+        struct btree * tree;
+        tRecord record;
+
+        keywordCount = config_setting_length( keywords );
+
+        int       nDigits = 1;
+        for ( int i       = keywordCount; i > 10; i /= 10 ) { ++nDigits; }
+
+        tParsedArray * parsedArray = calloc( keywordCount, sizeof( tParsedArray ));
+        if ( parsedArray == NULL)
+        {
+            printError( "failed to allocate memory" );
+        }
+        else
+        {
+            const char * src;
+            const char * anchor;
+
+            for ( i = 0; i < keywordCount; i++ )
+            {
+                element = config_setting_get_elem( keywords, i );
+                if ( element != NULL)
+                {
+                    if ( config_setting_type( element ) != CONFIG_TYPE_STRING )
+                    {
+                        printError( "keyword must be a string, in file \"%s\" at line %d",
+                                    config_setting_source_file( element ),
+                                    config_setting_source_line( element ));
+                    }
+                    else
+                    {
+                        const char * keyword = config_setting_get_string( element );
+                        if ( keyword != NULL)
+                        {
+                            src    = keyword;
+                            anchor = keyword;
+                            int commaCounter = 0;
+
+                            do
+                            {
+                                switch ( *src )
+                                {
+                                case ',':
+                                    if ( commaCounter == 0 )
+                                    {
+                                        /* end of initial keyword, but we have at least one more term to hash */
+                                        parsedArray[ i ].keyword = strndup( anchor, src - anchor );
+                                        anchor = &src[ 1 ]; /* drop anchor at the start of the hashed words */
+                                    }
+                                    else if ( commaCounter == 1 )
+                                    {
+                                        size_t size = ( src - anchor ) + 2 + 1;
+                                        char * lookup = calloc( 1, size );
+                                        if ( lookup != NULL)
+                                        {
+                                            const char * s = anchor;
+                                            char       * d = lookup;
+                                            *d++ = '\"';
+                                            while ( s < src )
+                                            {
+                                                *d++ = *s++;
+                                            }
+                                            *d++ = '\"';
+                                            *d   = '\0';
+                                            parsedArray[ i ].lookup = lookup;
+                                        }
+                                    }
+
+                                    ++commaCounter;
+                                    break;
+
+                                    /* semicolon means end of hash list & start of explicit reverse lookup string */
+                                case ';':
+                                    if ( commaCounter == 0 )
+                                    {
+                                        /* end of initial keyword, but we have at least one more term to hash */
+                                        parsedArray[ i ].keyword = strndup( anchor, src - anchor );
+                                    }
+                                    parsedArray[ i ].hashed =
+                                        strndup( anchor, src - anchor );  /* remember the list of hashed words */
+
+                                    do { ++src; } while (isspace( *src ));
+
+                                    /* don't leak the existing reverse lookup string, if there is one */
+                                    if ( parsedArray[ i ].lookup != NULL)
+                                    {
+                                        free( parsedArray[ i ].lookup );
+                                        parsedArray[ i ].lookup = NULL;
+                                    }
+                                    parsedArray[ i ].lookup =
+                                        strdup( src ); /* remember the explicit reverse lookup provided */
+                                    /* terminate the loop */
+                                    src = "";
+                                    break;
+
+                                case '\0':
+                                default:break;
+                                }
+                            } while ( *src++ != '\0' );
+
+                            if ( parsedArray[ i ].keyword == NULL)
+                            {
+                                parsedArray[ i ].keyword = strdup( anchor );
+                            }
+
+                            if ( parsedArray[ i ].hashed == NULL)
+                            {
+                                parsedArray[ i ].hashed = strdup( anchor );
+                            }
+
+                            if ( parsedArray[ i ].lookup == NULL)
+                            {
+                                /* if reverse lookup isn't already set to something better, use the keyword */
+                                asprintf( &parsedArray[ i ].lookup, "\"%s\"", anchor );
+                            }
+                        }
+                    }
+                }
+            }
+
+            int maxKeywordLen = 0;
+            for ( i = 0; i < keywordCount; i++ )
+            {
+                maxKeywordLen = max( maxKeywordLen, strlen( parsedArray[ i ].keyword ));
+            }
+
+            /* emit the enum */
+            fprintf( globals.outputFile, kHashEnumPrefix, globals.prefix );
+            for ( i = 0; i < keywordCount; i++ )
+            {
+                fprintf( globals.outputFile,
+                         "    k%s%*s = %*u,\n",
+                         globals.prefix, -maxKeywordLen, parsedArray[ i ].keyword, nDigits, i + 1 );
+            }
+            fprintf( globals.outputFile, kHashEnumSuffix,
+                     globals.prefix, i + 1, globals.prefix );
+
+            /* emit the enum -> string lookup */
+            if ( globals.reverseMapPrefix == NULL)
+            {
+                asprintf( &globals.reverseMapPrefix, kReverseMapPrefix, globals.prefix );
+            }
+            fprintf( globals.outputFile, "%s", globals.reverseMapPrefix );
+
+            fprintf( globals.outputFile, " = {\n" );
             if ( globals.reverseUnsetEntry == NULL)
             {
                 fprintf( globals.outputFile,
@@ -621,35 +2754,73 @@ int processKeywords( config_t * config )
             }
             fprintf( globals.outputFile, "};\n\n" );
 
+            if ( globals.seedSearch > 0 )
+            {
+                result = searchSeed( parsedArray, keywordCount );
+            }
+
             /* create a b-tree */
             tree = btree_new( sizeof( tRecord ), 0, compareRecords, &globals );
 
+            unsigned int collisions = 0;
+            unsigned int separable  = 0;
             for ( i = 0; i < keywordCount; i++ )
             {
                 src = parsedArray[ i ].hashed;
                 while ( *src != '\0' )
                 {
-                    tHash hash = 0;
                     const char * hashedString = src;
-                    while ( *src != '\0' && *src != ',' )
+                    src += strcspn( src, "," );
+
+                    tHash hash = hashKeyword( globals.seed, hashedString, src - hashedString );
+
+                    if ( globals.hashBits == 32 )
                     {
-                        hash = hashChar( hash, remapChar( gCharMap, *src ));
-                        src++;
+                        hash = narrowHash( hash );
                     }
 
                     /* insert into B+Tree */
                     record.hash         = hash;
                     record.hashedString = strndup( hashedString, src - hashedString );
                     record.index        = i;
-                    btree_set( tree, &record );
+                    tRecord * previous  = btree_set( tree, &record );
+
+                    /* a collision is only harmless if it's between aliases of the same keyword -
+                     * otherwise the later string has replaced the earlier one in the tree */
+                    if ( previous != NULL && previous->index != record.index )
+                    {
+                        printError( "\"%s\" (k%s%s) and \"%s\" (k%s%s) have the same %d-bit hash, %s",
+                                    previous->hashedString, globals.prefix, parsedArray[ previous->index ].keyword,
+                                    record.hashedString, globals.prefix, parsedArray[ i ].keyword,
+                                    globals.hashBits, hashLiteral( hash ));
+                        collisions++;
+                        if ( !sameMapping( previous->hashedString, strlen( previous->hashedString ),
+                                           record.hashedString, strlen( record.hashedString )))
+                        {
+                            separable++;
+                        }
+                    }
 
                     if ( *src != '\0' ) { ++src; }
                 }
             }
 
+            /* a narrowed table is a choice to rely on the keywords being collision-free, but
+             * a 64-bit collision has always been let through, at the cost of one of the strings */
+            if ( collisions > 0 )
+            {
+                printError( "the %s keywords are not collision-free at %d bits (%u collisions)%s",
+                            globals.prefix, globals.hashBits, collisions,
+                            ( globals.seedSearch == 0 && separable > 0 ) ? " - set seedSearch to look for a seed that avoids them" : "" );
+                if ( globals.hashBits == 32 )
+                {
+                    result = -1;
+                }
+            }
+
             tArray array;
             array.count = btree_count( tree );
-            if ( array.count > 0 )
+            if ( array.count > 0 && result == 0 )
             {
                 array.record = calloc( array.count, sizeof( tRecord * ));
                 if ( array.record != NULL)
@@ -657,73 +2828,267 @@ int processKeywords( config_t * config )
                     array.index = 0;
                     btree_ascend( tree, NULL, storeRecord, &array );
 
-                    skipTable = (tRecord *)calloc( array.count, sizeof( tRecord ));
-                    if ( skipTable != NULL)
+                    tKeywordSet set;
+                    set.parsed        = parsedArray;
+                    set.keywordCount  = keywordCount;
+                    set.maxKeywordLen = maxKeywordLen;
+                    set.nDigits       = nDigits;
+                    set.sorted        = array.record;
+                    set.count         = array.count;
+                    set.maxHashedLen  = 0;
+                    for ( i = 0; i < array.count; i++ )
                     {
-                        fillTable( 0, skipTable, array.record, 0, array.count );
+                        set.maxHashedLen = max( set.maxHashedLen, strlen( array.record[ i ]->hashedString ));
+                    }
 
-                        int maxHashedLen = 0;
-                        for ( i = 0; i < array.count; i++ )
-                        {
-                            maxHashedLen = max( maxHashedLen, strlen( skipTable[ i ].hashedString ));
-                        }
+                    result = emitSearchTable( &set );
+                }
+            }
+        } /* allocation of arrays succeeded */
+    } /* keywords is a valid array */
 
-                        fprintf( globals.outputFile, kHashMapPrefix, globals.prefix );
+    return result;
+}
 
-                        for ( i = 0; i < array.count; i++ )
-                        {
-                            fprintf(
-                                globals.outputFile,
-                                "    { 0x%016lx, \"%s\",%*ck%s%s,%*c%*u, %*u }",
-                                skipTable[ i ].hash,
-                                skipTable[ i ].hashedString,
-                                (int)( strlen( skipTable[ i ].hashedString ) - maxHashedLen - 1 ), ' ',
-                                globals.prefix, parsedArray[ skipTable[ i ].index ].keyword,
-                                (int)( strlen( parsedArray[ skipTable[ i ].index ].keyword ) - maxKeywordLen - 1 ), ' ',
-                                nDigits, skipTable[ i ].lower,
-                                nDigits, skipTable[ i ].higher );
-                            if ( i < array.count - 1 )
-                            {
-                                fputc( ',', globals.outputFile );
-                            }
-                            fputc( '\n', globals.outputFile );
-                        }
+int selectLayout( const char * name )
+{
+    int result = 0;
 
-                        fprintf( globals.outputFile, "};\n\n" );
-#if 0
-                        /* do a quick sanity check */
-                        for ( i = 0; i < parsedArray.count; i++ )
-                        {
-                            tIndex index = findHash( skipTable, parsedArray.record[i]->hash );
+    globals.emit = kEmitTree;
+    if ( name != NULL)
+    {
+        unsigned int i;
+        for ( i = 0; i < sizeof( kEmitLayouts ) / sizeof( kEmitLayouts[ 0 ] ); i++ )
+        {
+            if ( strcasecmp( name, kEmitLayouts[ i ].name ) == 0 )
+            {
+                globals.emit = kEmitLayouts[ i ].layout;
+                break;
+            }
+        }
+        if ( i == sizeof( kEmitLayouts ) / sizeof( kEmitLayouts[ 0 ] ))
+        {
+            printError( "unknown table layout \'%s\'", name );
+            result = -1;
+        }
+    }
+    return result;
+}
 
-                            fprintf( stderr, "0x%016lx ", parsedArray.record[i].hash );
-                            if ( index < parsedArray.count )
-                            {
-                                tRecord * r = &skipTable[index];
-                                fprintf( stderr, "k%s%s, \"%s\"\n",
-                                         globals.prefix, keywordArray[r->index], r->hashedString );
-                            } else {
-                                fprintf( stderr, "not found\n" );
-                            }
-                        }
-#endif
-                    }
-                }
+int selectHashFunction( const char * name )
+{
+    int result = 0;
+
+    globals.hashFunction = kHashLegacy;
+    if ( name != NULL)
+    {
+        unsigned int i;
+        for ( i = 0; i < sizeof( kHashFunctions ) / sizeof( kHashFunctions[ 0 ] ); i++ )
+        {
+            if ( strcasecmp( name, kHashFunctions[ i ].name ) == 0 )
+            {
+                globals.hashFunction = kHashFunctions[ i ].function;
+                break;
             }
-        } /* allocation of arrays succeeded */
-    } /* keywords is a valid array */
+        }
+        if ( i == sizeof( kHashFunctions ) / sizeof( kHashFunctions[ 0 ] ))
+        {
+            printError( "unknown hash function \'%s\'", name );
+            result = -1;
+        }
+    }
+    return result;
+}
+
+/*
+ * filter:
+ * {
+ *     type       = "bloom";   # or "bitmap", for a single probe
+ *     bitsPerKey = 10;
+ * }
+ */
+int processFilter( config_t * config )
+{
+    int result = 0;
+    config_setting_t * filter;
+
+    globals.filterProbes = 0;
+
+    filter = config_lookup( config, "filter" );
+    if ( filter != NULL)
+    {
+        const char * type       = "bloom";
+        int          bitsPerKey = 10;
+
+        if ( !config_setting_is_group( filter ))
+        {
+            printError( "filter is not a group in file \"%s\" at line %d",
+                        config_setting_source_file( filter ),
+                        config_setting_source_line( filter ));
+            return -1;
+        }
+
+        /* the trie matches strings without hashing them, so there's no hash to filter */
+        if ( globals.emit == kEmitTrie )
+        {
+            printError( "filter is not supported by the trie layout, in file \"%s\" at line %d",
+                        config_setting_source_file( filter ),
+                        config_setting_source_line( filter ));
+            return -1;
+        }
+
+        config_setting_lookup_string( filter, "type", &type );
+        config_setting_lookup_int( filter, "bitsPerKey", &bitsPerKey );
 
+        if ( bitsPerKey < 1 || bitsPerKey > 64 )
+        {
+            printError( "filter bitsPerKey must be between 1 and 64, in file \"%s\" at line %d",
+                        config_setting_source_file( filter ),
+                        config_setting_source_line( filter ));
+            result = -1;
+        }
+        else if ( strcasecmp( type, "bloom" ) == 0 )
+        {
+            /* the optimal number of probes is bitsPerKey * ln(2) */
+            globals.filterProbes = ( bitsPerKey * 69 + 50 ) / 100;
+            if ( globals.filterProbes < 1 ) { globals.filterProbes = 1; }
+            if ( globals.filterProbes > 8 ) { globals.filterProbes = 8; }
+        }
+        else if ( strcasecmp( type, "bitmap" ) == 0 )
+        {
+            globals.filterProbes = 1;
+        }
+        else
+        {
+            printError( "unknown filter type \'%s\', in file \"%s\" at line %d", type,
+                        config_setting_source_file( filter ),
+                        config_setting_source_line( filter ));
+            result = -1;
+        }
+        globals.filterBitsPerKey = bitsPerKey;
+    }
     return result;
 }
 
 int processStructure( config_t * config )
 {
     int result;
+    const char * layout = NULL;
 
     config_lookup_string( config, "prefix", &globals.prefix );
 
+    /* each file's header needs its own character map */
+    globals.charMapEmitted = false;
+    globals.charMapWide    = false;
+
+    /* the layout given on the command line takes precedence over the one in the file */
+    layout = globals.emitOverride;
+    if ( layout == NULL)
+    {
+        config_lookup_string( config, "emit", &layout );
+    }
+    result = selectLayout( layout );
+    globals.emitDefault = ( layout == NULL );
+
+    /* likewise for the hash function */
+    const char * function = globals.hashOverride;
+    if ( function == NULL)
+    {
+        config_lookup_string( config, "hash", &function );
+    }
+    if ( selectHashFunction( function ) != 0 )
+    {
+        result = -1;
+    }
+
+    globals.emitStrings = false;
+    config_lookup_bool( config, "strings", &globals.emitStrings );
+
+    globals.bucketSize = 2.0;
+    if ( config_lookup_float( config, "bucketSize", &globals.bucketSize ) != CONFIG_TRUE )
+    {
+        int bucketSize;
+        if ( config_lookup_int( config, "bucketSize", &bucketSize ) == CONFIG_TRUE )
+        {
+            globals.bucketSize = bucketSize;
+        }
+    }
+    if ( globals.bucketSize < 0.25 )
+    {
+        printError( "bucketSize must be at least 0.25" );
+        result = -1;
+    }
+
+    globals.loadFactor = 0.875;
+    config_lookup_float( config, "loadFactor", &globals.loadFactor );
+    if ( globals.loadFactor <= 0.0 || globals.loadFactor > 0.95 )
+    {
+        printError( "loadFactor must be more than 0 and at most 0.95" );
+        result = -1;
+    }
+
+    globals.groupSize = 16;
+    config_lookup_int( config, "groupSize", &globals.groupSize );
+    if ( globals.groupSize != 8 && globals.groupSize != 16 )
+    {
+        printError( "groupSize must be 8 or 16, not %d", globals.groupSize );
+        result = -1;
+    }
+
+    globals.emitPool = false;
+    config_lookup_bool( config, "verify", &globals.emitPool );
+
+    globals.seed = 0;
+    long long seed;
+    if ( config_lookup_int64( config, "seed", &seed ) == CONFIG_TRUE )
+    {
+        globals.seed = (tHash)seed;
+    }
+
+    globals.seedSearch = 0;
+    int seedSearch;
+    if ( config_lookup_int( config, "seedSearch", &seedSearch ) == CONFIG_TRUE )
+    {
+        if ( seedSearch < 0 )
+        {
+            printError( "seedSearch must not be negative" );
+            result = -1;
+        }
+        else
+        {
+            globals.seedSearch = seedSearch;
+        }
+    }
+
+    globals.emitDispatch = false;
+    config_lookup_bool( config, "dispatch", &globals.emitDispatch );
+
+    globals.hashBits = 64;
+    config_lookup_int( config, "hashBits", &globals.hashBits );
+    if ( globals.hashBits != 64 && globals.hashBits != 32 )
+    {
+        printError( "hashBits must be 32 or 64, not %d", globals.hashBits );
+        result = -1;
+    }
+    else if ( globals.hashBits == 32 && !globals.emitDefault
+           && globals.emit != kEmitEytzinger && globals.emit != kEmitSplit && globals.emit != kEmitCode
+           && globals.emit != kEmitScan )
+    {
+        printError( "hashBits = 32 is only supported by the eytzinger, split, code and scan layouts" );
+        result = -1;
+    }
+
+    if ( result == 0 )
+    {
+        result = processFilter( config );
+    }
+
     /* first, we need to build the character mapping */
-    result = processMapping( config );
+    if ( result == 0 )
+    {
+        result = processMapping( config );
+        buildWordMap( gCharMap, &gWordMap );
+    }
 
     /* array is complete, so now we can generate the hashes */
     if ( result == 0 )
@@ -801,6 +3166,16 @@ int main( int argc, char * argv[] )
                                           "<extension>",
                                           0, 1,
                                           "set the extension to use for output files (default: .h)" ),
+                 gOption.emit = arg_strn( "e", "emit",
+                                          "<layout>",
+                                          0, 1,
+                                          "set the layout of the emitted search table: tree, eytzinger, perfect, split, stree, code, radix, swiss, trie, complete or scan"
+                                          " (default: the 'emit' setting in the input file, else scan for up to 64 strings, or tree)" ),
+                 gOption.hash = arg_strn( NULL, "hash",
+                                          "<function>",
+                                          0, 1,
+                                          "set the hash function: legacy, fnv1a, wyhash, crc32c, word or polynomial"
+                                          " (default: the 'hash' setting in the input file, else legacy)" ),
                  gOption.file = arg_filen(NULL, NULL,
                                           "<file>",
                                           1, 999,
@@ -845,6 +3220,16 @@ int main( int argc, char * argv[] )
             extension = *gOption.extn->sval;
         }
 
+        if ( gOption.emit->count != 0 )
+        {
+            globals.emitOverride = *gOption.emit->sval;
+        }
+
+        if ( gOption.hash->count != 0 )
+        {
+            globals.hashOverride = *gOption.hash->sval;
+        }
+
         for ( int i = 0; i < gOption.file->count && result == 0; ++i )
         {
             char output[FILENAME_MAX];
@@ -6,12 +6,37 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <string.h>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+#endif
 
 #include "libhashstrings.h"
 
 const uint64_t kFieldMask = 0x01FFL; // mask for the 9 lsb
 static const int kHashFactor = 43;
 
+/* number of lookups findHashBatch() keeps in flight at once */
+#define kBatchWidth 16
+
+/* characters remapped at a time by hashString() and hashStringN() - a multiple
+ * of four, so only the last chunk of a string can end in a partial word */
+#define kRemapChunk 64
+
+#define kFNVOffset      0xcbf29ce484222325ULL
+#define kFNVPrime       0x00000100000001b3ULL
+#define kWyhash0        0xa0761d6478bd642fULL
+#define kWyhash1        0xe7037ed1a0b428dbULL
+#define kWyhash2        0x8ebc6af09c88c6e3ULL
+#define kCRC32CPoly     0x82f63b78U
+#define kCRCMultiplier  0x9e3779b97f4a7c15ULL
+#define kPolynomialBase 0x9fb21c651e98df25ULL
+
+/* characters of the polynomial hash in flight at once, and the shortest string worth it */
+#define kPolynomialLanes    16
+#define kPolynomialMinimum  64
+
 void setCharMap( tCharMap * charMap,
                  const unsigned char c,
                  const tMappedChar mappedC )
@@ -21,59 +46,1559 @@ void setCharMap( tCharMap * charMap,
                       ((mappedC & kFieldMask) << shft);
 }
 
-tMappedChar remapChar( tCharMap * charMap, const unsigned char c )
+tMappedChar remapChar( const tCharMap * charMap, const unsigned char c )
 {
     return ((charMap[ c/7 ] >> (( c % 7 ) * 9)) & kFieldMask);
 }
 
+static inline void remapBufferScalar( const tCharMap * charMap,
+                                      const uint8_t * in,
+                                      tMappedChar * out,
+                                      size_t n )
+{
+    for ( size_t i = 0; i < n; i++ )
+    {
+        out[ i ] = remapChar( charMap, in[ i ] );
+    }
+}
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+
+/*
+ * Byte c's field starts at bit 64 * (c / 7) + 9 * (c % 7) = 9c + c/7 of the map,
+ * and c/7 is (c * 293) >> 11 for every byte. A 9-bit field never spans more than
+ * two bytes, so a gather of 32 bits at the field's byte offset (scale 1, unaligned)
+ * always contains it - and never reads past the end of the map.
+ */
+__attribute__(( target( "avx2" )))
+static inline __m256i remapEightAVX2( const tCharMap * charMap, const uint8_t * in )
+{
+    __m256i c     = _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i *)in ));
+    __m256i bit   = _mm256_add_epi32( _mm256_add_epi32( _mm256_slli_epi32( c, 3 ), c ),
+                                      _mm256_srli_epi32( _mm256_mullo_epi32( c, _mm256_set1_epi32( 293 )), 11 ));
+    __m256i field = _mm256_i32gather_epi32( (const int *)charMap, _mm256_srli_epi32( bit, 3 ), 1 );
+
+    return _mm256_and_si256( _mm256_srlv_epi32( field, _mm256_and_si256( bit, _mm256_set1_epi32( 7 ))),
+                             _mm256_set1_epi32( kFieldMask ));
+}
+
+__attribute__(( target( "avx2" )))
+static void remapBufferAVX2( const tCharMap * charMap,
+                             const uint8_t * in,
+                             tMappedChar * out,
+                             size_t n )
+{
+    size_t i = 0;
+
+    for ( ; i + 16 <= n; i += 16 )
+    {
+        __m256i lo = remapEightAVX2( charMap, &in[ i ] );
+        __m256i hi = remapEightAVX2( charMap, &in[ i + 8 ] );
+
+        /* packing works within each 128-bit lane, so put the lanes back in order after */
+        __m256i packed = _mm256_permute4x64_epi64( _mm256_packus_epi32( lo, hi ), 0xd8 );
+        _mm256_storeu_si256( (__m256i *)&out[ i ], packed );
+    }
+    remapBufferScalar( charMap, &in[ i ], &out[ i ], n - i );
+}
+
+#endif
+
+/*
+ * remap a run of bytes at once, so the 9-bit field extraction can be vectorized.
+ * pshufb can only look up a 16-entry table, which is why there is no SSSE3
+ * version: the map would have to be expanded into a new form on every call.
+ */
+void remapBuffer( const tCharMap * charMap,
+                  const uint8_t * in,
+                  tMappedChar * out,
+                  size_t n )
+{
+#if defined( __x86_64__ ) || defined( __i386__ )
+    if ( n >= 16 && __builtin_cpu_supports( "avx2" ))
+    {
+        remapBufferAVX2( charMap, in, out, n );
+        return;
+    }
+#endif
+    remapBufferScalar( charMap, in, out, n );
+}
+
 tHash hashChar( tHash hash, tMappedChar mappedC )
 {
     return (hash ^ ((hash * kHashFactor) + mappedC));
 }
 
+/* stops at the first character that maps to '\0', which includes the terminator */
 tHash hashString(const char * string, tCharMap * charMap )
 {
     tHash hash = 0;
-    const unsigned char * p = (const unsigned char *)string;
+    const uint8_t * p = (const uint8_t *)string;
+    size_t length = strlen( string );
+    tMappedChar mapped[ kRemapChunk ];
+
+    while ( length > 0 )
+    {
+        size_t n = ( length < kRemapChunk ) ? length : kRemapChunk;
+
+        remapBuffer( charMap, p, mapped, n );
+        for ( size_t i = 0; i < n; i++ )
+        {
+            if ( mapped[ i ] == '\0' )
+            {
+                return hash;
+            }
+            hash = hashChar( hash, mapped[ i ] );
+        }
+        p += n;
+        length -= n;
+    }
+
+    return hash;
+}
+
+/*
+ * as hashString(), but with the map expanded to one entry per byte (as the
+ * generator emits it, in g<Prefix>CharMapFlat) - a load per character, and
+ * nothing to extract from it
+ */
+tHash hashStringFlat( const char * string, const uint16_t flatMap[256] )
+{
+    tHash hash = 0;
+    const uint8_t * p = (const uint8_t *)string;
     tMappedChar c;
 
-    do {
-        c = remapChar( charMap, *p++ );
-        if ( c != '\0' && c < 256 )
+    while (( c = flatMap[ *p++ ] ) != '\0' )
+    {
+        hash = hashChar( hash, c );
+    }
+    return hash;
+}
+
+/* for maps without symbols, where every mapped character fits in a byte */
+tHash hashStringFlat8( const char * string, const uint8_t flatMap[256] )
+{
+    tHash hash = 0;
+    const uint8_t * p = (const uint8_t *)string;
+    tMappedChar c;
+
+    while (( c = flatMap[ *p++ ] ) != '\0' )
+    {
+        hash = hashChar( hash, c );
+    }
+    return hash;
+}
+
+tHash32 hashString32( const char * string, tCharMap * charMap )
+{
+    return narrowHash( hashString( string, charMap ));
+}
+
+/* as hashString(), but for the first 'length' bytes of a string that need not be terminated */
+tHash hashStringN( const char * string, size_t length, const tCharMap * charMap )
+{
+    tHash hash = 0;
+    const uint8_t * p = (const uint8_t *)string;
+    tMappedChar mapped[ kRemapChunk ];
+
+    while ( length > 0 )
+    {
+        size_t n = ( length < kRemapChunk ) ? length : kRemapChunk;
+
+        remapBuffer( charMap, p, mapped, n );
+        for ( size_t i = 0; i < n; i++ )
         {
-            hash = hashChar( hash, c );
+            hash = hashChar( hash, mapped[ i ] );
         }
-    } while ( c != '\0' );
+        p += n;
+        length -= n;
+    }
 
     return hash;
 }
 
-tIndex findHash( tRecord skipTable[], tHash hash )
+static inline uint64_t wyMix( uint64_t a, uint64_t b )
 {
-    tIndex i = 0;
+#ifdef __SIZEOF_INT128__
+    __uint128_t product = (__uint128_t)a * b;
+    return (uint64_t)product ^ (uint64_t)( product >> 64 );
+#else
+    /* no 128-bit type - build the high half from four 32 x 32-bit products */
+    uint64_t lowA  = a & 0xffffffff, highA = a >> 32;
+    uint64_t lowB  = b & 0xffffffff, highB = b >> 32;
+    uint64_t cross = lowA * highB;
+    uint64_t other = highA * lowB;
+    uint64_t carry = (( lowA * lowB ) >> 32 ) + ( cross & 0xffffffff ) + ( other & 0xffffffff );
+    uint64_t high  = highA * highB + ( cross >> 32 ) + ( other >> 32 ) + ( carry >> 32 );
+    return ( a * b ) ^ high;
+#endif
+}
 
-    do {
-        // fprintf(stderr, "%02d-0x%016lx ", i, skipTable[i].hash);
+/* up to four mapped characters as one word - a short one at the end is zero filled */
+static inline uint64_t packMapped( const tMappedChar * mapped, size_t n )
+{
+    uint64_t word = 0;
 
-        if ( skipTable[i].hash == hash )
-        { // we found it, return the corresponding tIndex (1-based)
-            // fprintf( stderr, "match (%s)\n", skipTable[i].hashedString );
-            return skipTable[i].index;
+    for ( size_t i = 0; i < n && i < 4; i++ )
+    {
+        word |= (uint64_t)mapped[ i ] << ( 16 * i );
+    }
+    return word;
+}
+
+/* the same as the SSE4.2 crc32 instruction, a bit at a time */
+static inline uint32_t crc32cScalar( uint32_t crc, uint64_t word )
+{
+    uint64_t x = crc ^ word;
+
+    for ( int i = 0; i < 64; i++ )
+    {
+        x = ( x >> 1 ) ^ ( kCRC32CPoly & -( x & 1 ));
+    }
+    return (uint32_t)x;
+}
+
+/* two CRCs, of the words and of the words multiplied by an odd constant, make 64 bits */
+static inline tHash crc32cMapped( tHash hash, const tMappedChar * mapped, size_t n )
+{
+    uint32_t a = (uint32_t)hash;
+    uint32_t b = (uint32_t)( hash >> 32 );
+
+    for ( size_t i = 0; i < n; i += 4 )
+    {
+        uint64_t word = packMapped( &mapped[ i ], n - i );
+        a = crc32cScalar( a, word );
+        b = crc32cScalar( b, word * kCRCMultiplier );
+    }
+    return ((tHash)b << 32 ) | a;
+}
+
+static inline tHash crc32cFinal( tHash hash, size_t length )
+{
+    return ((tHash)crc32cScalar( (uint32_t)( hash >> 32 ), ~(uint64_t)length ) << 32 )
+         | crc32cScalar( (uint32_t)hash, length );
+}
+
+#if defined( __x86_64__ )
+
+__attribute__(( target( "sse4.2" )))
+static tHash crc32cMappedSSE42( tHash hash, const tMappedChar * mapped, size_t n )
+{
+    uint32_t a = (uint32_t)hash;
+    uint32_t b = (uint32_t)( hash >> 32 );
+
+    for ( size_t i = 0; i < n; i += 4 )
+    {
+        uint64_t word = packMapped( &mapped[ i ], n - i );
+        a = (uint32_t)_mm_crc32_u64( a, word );
+        b = (uint32_t)_mm_crc32_u64( b, word * kCRCMultiplier );
+    }
+    return ((tHash)b << 32 ) | a;
+}
+
+__attribute__(( target( "sse4.2" )))
+static tHash crc32cFinalSSE42( tHash hash, size_t length )
+{
+    return ((tHash)(uint32_t)_mm_crc32_u64( (uint32_t)( hash >> 32 ), ~(uint64_t)length ) << 32 )
+         | (uint32_t)_mm_crc32_u64( (uint32_t)hash, length );
+}
+
+#endif
+
+#define kWordOnes   0x0101010101010101ULL
+#define kWordHighs  0x8080808080808080ULL
+
+/*
+ * Fold every byte to the lowest byte with the same mapped character - the folding
+ * keeps distinct mapped characters distinct, and fits in a byte. Then describe the
+ * ASCII bytes as runs, so most words can be folded without the table.
+ */
+void buildWordMap( const tCharMap * charMap, tWordMap * wordMap )
+{
+    uint16_t lowest[ 512 ];
+
+    memset( lowest, 0xff, sizeof( lowest ));
+    for ( unsigned int c = 0; c < 256; c++ )
+    {
+        tMappedChar mapped = remapChar( charMap, c );
+        if ( lowest[ mapped ] == 0xffff )
+        {
+            lowest[ mapped ] = c;
         }
-        else if ( skipTable[i].hash > hash )
-        { /* hash is lower than this record */
-            i = skipTable[i].lower;
-            // fprintf( stderr, "lower (%u)\n", i );
+        wordMap->fold[ c ] = (uint8_t)lowest[ mapped ];
+    }
+
+    /* a byte folds to itself or to one below it, so a run can only subtract */
+    const uint8_t * fold = wordMap->fold;
+    unsigned int ranges = 0;
+    unsigned int c = 0;
+    while ( c < 128 )
+    {
+        if ( fold[ c ] == c )
+        {
+            c++;
+            continue;
+        }
+
+        unsigned int offsetEnd = c;
+        while ( offsetEnd + 1 < 128 && offsetEnd + 1 - fold[ offsetEnd + 1 ] == c - fold[ c ] )
+        {
+            offsetEnd++;
+        }
+        unsigned int valueEnd = c;
+        while ( valueEnd + 1 < 128 && fold[ valueEnd + 1 ] == fold[ c ] )
+        {
+            valueEnd++;
+        }
+
+        if ( ranges == kWordRanges )
+        {
+            ranges = 0;
+            break;
+        }
+        tWordRange * range = &wordMap->range[ ranges++ ];
+        range->first = c;
+        if ( offsetEnd >= valueEnd )
+        {
+            range->last     = offsetEnd;
+            range->subtract = c - fold[ c ];
+            range->value    = 0;
         }
         else
-        { /* hash is higher than this record */
-            i = skipTable[i].higher;
-            // fprintf( stderr, "higher (%u)\n", i );
+        {
+            range->last     = valueEnd;
+            range->subtract = 0;
+            range->value    = fold[ c ];
         }
-    } while ( i != kLeaf );
+        c = range->last + 1;
+    }
+    if ( c < 128 )
+    {
+        memset( wordMap->range, 0, sizeof( wordMap->range ));
+    }
+    wordMap->ranges = ranges;
+}
 
-    // fprintf( stderr, "no match\n" );
-    return 0;
+/* eight ASCII bytes at once: the high bit of each byte says whether it's in the run */
+static inline uint64_t foldWordSWAR( const tWordMap * wordMap, uint64_t word )
+{
+    uint64_t folded = word;
+
+    for ( unsigned int i = 0; i < wordMap->ranges; i++ )
+    {
+        const tWordRange * range = &wordMap->range[ i ];
+        uint64_t atLeastFirst = word + ( 0x80 - range->first ) * kWordOnes;
+        uint64_t pastLast     = word + ( 0x7f - range->last ) * kWordOnes;
+        uint64_t inRange      = (( atLeastFirst & ~pastLast ) & kWordHighs ) >> 7;
+        uint64_t mask         = inRange * 0xff;
+
+        if ( range->subtract != 0 )
+        {
+            folded -= inRange * range->subtract;
+        }
+        else
+        {
+            folded = ( folded & ~mask ) | ( mask & ( range->value * kWordOnes ));
+        }
+    }
+    return folded;
+}
+
+/* up to eight bytes, folded, as one word - a short one at the end is zero filled */
+static inline uint64_t foldWord( const tWordMap * wordMap, const uint8_t * p, size_t n )
+{
+    uint64_t word = 0;
+
+    if ( n >= 8 && wordMap->ranges != 0 )
+    {
+        memcpy( &word, p, 8 );
+        if (( word & kWordHighs ) == 0 )
+        {
+            word = foldWordSWAR( wordMap, word );
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            word = __builtin_bswap64( word );
+#endif
+            return word;
+        }
+        word = 0;
+    }
+
+    for ( size_t i = 0; i < n && i < 8; i++ )
+    {
+        word |= (uint64_t)wordMap->fold[ p[ i ] ] << ( 8 * i );
+    }
+    return word;
+}
+
+/*
+ * The word hash: the string's bytes folded by the word map, eight to a 64-bit word,
+ * mixed as wyhash mixes them - a multiply per eight characters rather than one per
+ * character, and no 9-bit fields to extract. The generated hash<Prefix>N() calls
+ * this with the dictionary's own word map.
+ */
+tHash hashStringWord( const tWordMap * wordMap,
+                      tHash seed,
+                      const char * string,
+                      size_t length )
+{
+    const uint8_t * p = (const uint8_t *)string;
+    tHash hash = seed;
+
+    for ( size_t i = 0; i < length; i += 8 )
+    {
+        hash = wyMix( foldWord( wordMap, &p[ i ], length - i ) ^ kWyhash1, hash ^ kWyhash0 );
+    }
+    return wyMix( hash ^ length, kWyhash2 );
+}
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+
+/* the low 64 bits of a 64 x 64-bit product, from 32 x 32-bit ones - AVX2 has no vpmullq */
+__attribute__(( target( "avx2" )))
+static inline __m256i multiply64AVX2( __m256i a, __m256i b )
+{
+    __m256i low   = _mm256_mul_epu32( a, b );
+    __m256i cross = _mm256_add_epi64( _mm256_mul_epu32( _mm256_srli_epi64( a, 32 ), b ),
+                                      _mm256_mul_epu32( a, _mm256_srli_epi64( b, 32 )));
+
+    return _mm256_add_epi64( low, _mm256_slli_epi64( cross, 32 ));
+}
+
+/*
+ * Lane l of the sixteen sums the characters l, l + 16, l + 32... by Horner's rule in
+ * K^16, so the sixteen multiply chains are independent. Then the lanes themselves are
+ * summed by Horner's rule in K, which leaves each character with the power of K it
+ * would have had one at a time. The leading 1 (K^n, in the end) starts off in the
+ * last lane, as the only one not multiplied by K again when the lanes are summed.
+ */
+__attribute__(( target( "avx2" )))
+static tHash hashPolynomialAVX2( const uint8_t * p, size_t blocks, const tCharMap * charMap, tHash base )
+{
+    tHash power = base;
+    for ( unsigned int i = 0; i < 4; i++ )
+    {
+        power *= power;
+    }
+    const __m256i k16 = _mm256_set1_epi64x( (long long)power );
+
+    __m256i sum[ 4 ] = {
+        _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(),
+        _mm256_set_epi64x( 1, 0, 0, 0 )
+    };
+
+    for ( size_t b = 0; b < blocks; b++, p += kPolynomialLanes )
+    {
+        __m256i lo = remapEightAVX2( charMap, p );
+        __m256i hi = remapEightAVX2( charMap, p + 8 );
+        __m256i mapped[ 4 ] = {
+            _mm256_cvtepu32_epi64( _mm256_castsi256_si128( lo )),
+            _mm256_cvtepu32_epi64( _mm256_extracti128_si256( lo, 1 )),
+            _mm256_cvtepu32_epi64( _mm256_castsi256_si128( hi )),
+            _mm256_cvtepu32_epi64( _mm256_extracti128_si256( hi, 1 ))
+        };
+
+        for ( unsigned int r = 0; r < 4; r++ )
+        {
+            sum[ r ] = _mm256_add_epi64( multiply64AVX2( sum[ r ], k16 ), mapped[ r ] );
+        }
+    }
+
+    tHash lane[ kPolynomialLanes ];
+    for ( unsigned int r = 0; r < 4; r++ )
+    {
+        _mm256_storeu_si256( (__m256i *)&lane[ 4 * r ], sum[ r ] );
+    }
+
+    tHash hash = 0;
+    for ( unsigned int l = 0; l < kPolynomialLanes; l++ )
+    {
+        hash = hash * base + lane[ l ];
+    }
+    return hash;
+}
+
+#endif
+
+/*
+ * The polynomial hash: K^n + the sum of mapped[i] * K^(n-1-i), modulo 2^64, where K
+ * is kPolynomialBase, or the seed (made odd). Unlike the legacy hash, no character
+ * waits on the one before it, so a long string is hashed in sixteen lanes at once
+ * (with AVX2). The rest, or all of a short string, is Horner's rule a character at
+ * a time - the same sum, so the two ways always agree.
+ */
+static tHash hashStringPolynomial( const char * string,
+                                   size_t length,
+                                   const tCharMap * charMap,
+                                   tHash seed )
+{
+    const uint8_t * p = (const uint8_t *)string;
+    tHash base = ( seed == 0 ) ? kPolynomialBase : ( seed | 1 );
+    tHash hash = 1;
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+    if ( length >= kPolynomialMinimum && __builtin_cpu_supports( "avx2" ))
+    {
+        size_t blocks = length / kPolynomialLanes;
+
+        hash = hashPolynomialAVX2( p, blocks, charMap, base );
+        p      += blocks * kPolynomialLanes;
+        length -= blocks * kPolynomialLanes;
+    }
+#endif
+
+    tMappedChar mapped[ kRemapChunk ];
+    while ( length > 0 )
+    {
+        size_t n = ( length < kRemapChunk ) ? length : kRemapChunk;
+
+        remapBuffer( charMap, p, mapped, n );
+        for ( size_t i = 0; i < n; i++ )
+        {
+            hash = hash * base + mapped[ i ];
+        }
+        p += n;
+        length -= n;
+    }
+    return hash;
+}
+
+/*
+ * Hash the first 'length' bytes of a string with the chosen function and seed.
+ * This is what the generator hashes the keywords with, so the two can't disagree.
+ * A seed of zero leaves each function as it is usually defined. For the legacy
+ * hash, the seed is the multiplier that replaces kHashFactor (made odd), and for
+ * the polynomial hash it is the base that replaces kPolynomialBase.
+ *
+ * The word hash needs the character map folded into a tWordMap, which this builds
+ * afresh on every call. That's fine for an occasional string, but anything hashing
+ * many should build one with buildWordMap() and call hashStringWord() itself, as
+ * the generator, the emitted hash<Prefix>N() and a tDispatch all do.
+ */
+tHash hashStringWith( tHashFunction function,
+                      tHash seed,
+                      const char * string,
+                      size_t length,
+                      const tCharMap * charMap )
+{
+    if ( function == kHashLegacy && seed == 0 )
+    {
+        return hashStringN( string, length, charMap );
+    }
+
+    if ( function == kHashPolynomial )
+    {
+        return hashStringPolynomial( string, length, charMap, seed );
+    }
+
+    if ( function == kHashWord )
+    {
+        tWordMap wordMap;
+
+        buildWordMap( charMap, &wordMap );
+        return hashStringWord( &wordMap, seed, string, length );
+    }
+
+    bool hardware = false;
+#if defined( __x86_64__ )
+    hardware = ( function == kHashCRC32C && __builtin_cpu_supports( "sse4.2" ));
+#endif
+
+    const uint8_t * p = (const uint8_t *)string;
+    size_t remaining = length;
+    tMappedChar mapped[ kRemapChunk ];
+    tHash hash;
+
+    switch ( function )
+    {
+    case kHashLegacy: hash = 0;                   break;
+    case kHashFNV1a:  hash = kFNVOffset ^ seed;   break;
+    case kHashWyhash: hash = seed;                break;
+    case kHashCRC32C:
+    default:          hash = ~0ULL ^ seed;        break;
+    }
+
+    while ( remaining > 0 )
+    {
+        size_t n = ( remaining < kRemapChunk ) ? remaining : kRemapChunk;
+
+        remapBuffer( charMap, p, mapped, n );
+        switch ( function )
+        {
+        case kHashLegacy:
+            for ( size_t i = 0; i < n; i++ )
+            {
+                hash ^= ( hash * ( seed | 1 )) + mapped[ i ];
+            }
+            break;
+
+        case kHashFNV1a:
+            for ( size_t i = 0; i < n; i++ )
+            {
+                hash = ( hash ^ mapped[ i ] ) * kFNVPrime;
+            }
+            break;
+
+        case kHashWyhash:
+            for ( size_t i = 0; i < n; i += 4 )
+            {
+                hash = wyMix( packMapped( &mapped[ i ], n - i ) ^ kWyhash1, hash ^ kWyhash0 );
+            }
+            break;
+
+        case kHashCRC32C:
+        default:
+#if defined( __x86_64__ )
+            if ( hardware )
+            {
+                hash = crc32cMappedSSE42( hash, mapped, n );
+                break;
+            }
+#endif
+            hash = crc32cMapped( hash, mapped, n );
+            break;
+        }
+        p += n;
+        remaining -= n;
+    }
+
+    /* the zero fill of a short last word is only told apart from mapped zeros by the length */
+    switch ( function )
+    {
+    case kHashLegacy:
+    case kHashFNV1a:
+        break;
+
+    case kHashWyhash:
+        hash = wyMix( hash ^ length, kWyhash2 );
+        break;
+
+    case kHashCRC32C:
+    default:
+#if defined( __x86_64__ )
+        if ( hardware )
+        {
+            hash = crc32cFinalSSE42( hash, length );
+            break;
+        }
+#endif
+        hash = crc32cFinal( hash, length );
+        break;
+    }
+    return hash;
+}
+
+/*
+ * The hash only ever carries state from one character to the next, so a string
+ * can be hashed in as many pieces as it arrives in, with the same result as
+ * hashing it all at once - no need to copy it into one buffer first.
+ */
+void hashInit( tHashContext * context, const tCharMap * charMap )
+{
+    context->hash    = 0;
+    context->charMap = charMap;
+}
+
+void hashUpdate( tHashContext * context, const void * bytes, size_t length )
+{
+    const unsigned char * p = bytes;
+    tHash hash = context->hash;
+
+    while ( length-- > 0 )
+    {
+        hash = hashChar( hash, remapChar( context->charMap, *p++ ));
+    }
+    context->hash = hash;
+}
+
+tHash hashFinal( const tHashContext * context )
+{
+    return context->hash;
+}
+
+tHash hashIovec( const struct iovec * iov, int iovcnt, const tCharMap * charMap )
+{
+    tHashContext context;
+
+    hashInit( &context, charMap );
+    for ( int i = 0; i < iovcnt; i++ )
+    {
+        hashUpdate( &context, iov[ i ].iov_base, iov[ i ].iov_len );
+    }
+    return hashFinal( &context );
+}
+
+#if defined( __x86_64__ )
+
+/* up to eight bytes of a string from offset i on, zero filled - never past its end */
+static inline uint64_t loadLane( const char * string, size_t length, size_t i )
+{
+    uint64_t word = 0;
+
+    if ( i + 8 <= length )
+    {
+        memcpy( &word, &string[ i ], 8 );
+    }
+    else if ( i < length )
+    {
+        memcpy( &word, &string[ i ], length - i );
+    }
+    return word;
+}
+
+/*
+ * A string to each 64-bit lane, four at once. Each lane loads eight bytes at a time,
+ * and takes them a byte per step: the mapped character is gathered as remapEightAVX2()
+ * does, and hash * 43 is (hash << 5) + (hash << 3) + (hash << 1) + hash, as AVX2 has
+ * no 64-bit multiply. A lane whose string has ended keeps its hash until the longest
+ * of the four has ended too.
+ */
+__attribute__(( target( "avx2" )))
+static size_t hashStringBatchAVX2( const char * const * strs,
+                                   const size_t * lens,
+                                   size_t n,
+                                   const tCharMap * charMap,
+                                   tHash * out )
+{
+    const __m256i byteMask  = _mm256_set1_epi64x( 0xff );
+    const __m256i fieldMask = _mm256_set1_epi64x( kFieldMask );
+    size_t s = 0;
+
+    for ( ; s + 4 <= n; s += 4 )
+    {
+        size_t longest = 0;
+        for ( unsigned int k = 0; k < 4; k++ )
+        {
+            longest = ( lens[ s + k ] > longest ) ? lens[ s + k ] : longest;
+        }
+
+        __m256i length = _mm256_loadu_si256( (const __m256i *)&lens[ s ] );
+        __m256i hash   = _mm256_setzero_si256();
+
+        for ( size_t i = 0; i < longest; i += 8 )
+        {
+            __m256i bytes = _mm256_set_epi64x( loadLane( strs[ s + 3 ], lens[ s + 3 ], i ),
+                                               loadLane( strs[ s + 2 ], lens[ s + 2 ], i ),
+                                               loadLane( strs[ s + 1 ], lens[ s + 1 ], i ),
+                                               loadLane( strs[ s + 0 ], lens[ s + 0 ], i ));
+
+            for ( size_t j = i; j < i + 8 && j < longest; j++ )
+            {
+                __m256i c     = _mm256_and_si256( bytes, byteMask );
+                __m256i bit   = _mm256_add_epi64( _mm256_add_epi64( _mm256_slli_epi64( c, 3 ), c ),
+                                                  _mm256_srli_epi64( _mm256_mul_epu32( c, _mm256_set1_epi64x( 293 )), 11 ));
+                __m256i field = _mm256_cvtepu32_epi64( _mm256_i64gather_epi32( (const int *)charMap,
+                                                                               _mm256_srli_epi64( bit, 3 ), 1 ));
+                __m256i mapped = _mm256_and_si256( _mm256_srlv_epi64( field, _mm256_and_si256( bit, _mm256_set1_epi64x( 7 ))),
+                                                   fieldMask );
+
+                __m256i times43 = _mm256_add_epi64( _mm256_add_epi64( _mm256_slli_epi64( hash, 5 ), _mm256_slli_epi64( hash, 3 )),
+                                                    _mm256_add_epi64( _mm256_slli_epi64( hash, 1 ), hash ));
+                __m256i next    = _mm256_xor_si256( hash, _mm256_add_epi64( times43, mapped ));
+                __m256i active  = _mm256_cmpgt_epi64( length, _mm256_set1_epi64x( (long long)j ));
+
+                hash  = _mm256_blendv_epi8( hash, next, active );
+                bytes = _mm256_srli_epi64( bytes, 8 );
+            }
+        }
+        _mm256_storeu_si256( (__m256i *)&out[ s ], hash );
+    }
+    return s;
+}
+
+#endif
+
+/*
+ * Hash n strings, given as pointers and lengths, to out[] - each the same as
+ * hashStringN() would give it. Four strings are hashed side by side if the CPU
+ * has AVX2, so strings of much the same length make the best use of the lanes.
+ */
+void hashStringBatch( const char * const * strs,
+                      const size_t * lens,
+                      size_t n,
+                      const tCharMap * charMap,
+                      tHash * out )
+{
+    size_t s = 0;
+
+#if defined( __x86_64__ )
+    if ( __builtin_cpu_supports( "avx2" ))
+    {
+        s = hashStringBatchAVX2( strs, lens, n, charMap, out );
+    }
+#endif
+    for ( ; s < n; s++ )
+    {
+        out[ s ] = hashStringN( strs[ s ], lens[ s ], charMap );
+    }
+}
+
+/*
+ * A hash match is only probable, not certain: confirm it by comparing the string,
+ * as mapped, against each of the strings that were hashed for that keyword.
+ */
+bool verifyMatch( const tStringPool * pool,
+                  const tCharMap * charMap,
+                  tIndex index,
+                  const char * string,
+                  size_t length )
+{
+    if ( index == kIndexUnset )
+    {
+        return false;
+    }
+
+    const unsigned char * p   = (const unsigned char *)&pool->bytes[ pool->offset[ index - 1 ] ];
+    const unsigned char * end = (const unsigned char *)&pool->bytes[ pool->offset[ index ] ];
+    const unsigned char * s   = (const unsigned char *)string;
+
+    while ( p < end )
+    {
+        size_t len = *p++;
+        if ( len == length )
+        {
+            size_t i = 0;
+            while ( i < len && remapChar( charMap, s[ i ] ) == remapChar( charMap, p[ i ] ))
+            {
+                i++;
+            }
+            if ( i == len )
+            {
+                return true;
+            }
+        }
+        p += len;
+    }
+    return false;
+}
+
+tIndex findHashVerified( tRecord skipTable[],
+                         const tStringPool * pool,
+                         const tCharMap * charMap,
+                         const char * string,
+                         size_t length )
+{
+    tIndex index = findHash( skipTable, hashStringN( string, length, charMap ));
+
+    return verifyMatch( pool, charMap, index, string, length ) ? index : kIndexUnset;
+}
+
+tIndex findHash( tRecord skipTable[], tHash hash )
+{
+    tIndex i = 0;
+
+    do {
+        // fprintf(stderr, "%02d-0x%016lx ", i, skipTable[i].hash);
+
+        if ( skipTable[i].hash == hash )
+        { // we found it, return the corresponding tIndex (1-based)
+            // fprintf( stderr, "match (%s)\n", skipTable[i].hashedString );
+            return skipTable[i].index;
+        }
+        else if ( skipTable[i].hash > hash )
+        { /* hash is lower than this record */
+            i = skipTable[i].lower;
+            // fprintf( stderr, "lower (%u)\n", i );
+        }
+        else
+        { /* hash is higher than this record */
+            i = skipTable[i].higher;
+            // fprintf( stderr, "higher (%u)\n", i );
+        }
+    } while ( i != kLeaf );
+
+    // fprintf( stderr, "no match\n" );
+    return 0;
+}
+
+/* for a token in the middle of a larger buffer, without copying it out first */
+tIndex findHashN( tRecord skipTable[],
+                  const tCharMap * charMap,
+                  const char * string,
+                  size_t length )
+{
+    return findHash( skipTable, hashStringN( string, length, charMap ));
+}
+
+/*
+ * Look up n hashes, writing the index of each (or kIndexUnset) to out[].
+ * Up to kBatchWidth independent walks of the tree advance in turn, one level
+ * each, prefetching their next record as they go - by the time a walk comes
+ * around again its record should have arrived, so the cache misses of the
+ * different walks overlap rather than stall one after another. When a walk
+ * finishes, its place is taken by the next hash waiting to be looked up.
+ */
+void findHashBatch( const tRecord skipTable[],
+                    const tHash * hashes,
+                    tIndex * out,
+                    size_t n )
+{
+    struct {
+        size_t which;
+        tIndex i;
+    } walk[ kBatchWidth ];
+
+    unsigned int active = 0;
+    size_t       next   = 0;
+
+    while ( active < kBatchWidth && next < n )
+    {
+        walk[ active ].which = next++;
+        walk[ active ].i     = 0;
+        active++;
+    }
+
+    while ( active > 0 )
+    {
+        unsigned int w = 0;
+        while ( w < active )
+        {
+            const tRecord * record = &skipTable[ walk[ w ].i ];
+            tHash hash = hashes[ walk[ w ].which ];
+            tIndex i;
+
+            if ( record->hash == hash )
+            {
+                out[ walk[ w ].which ] = record->index;
+                i = kLeaf;
+            }
+            else
+            {
+                i = ( record->hash > hash ) ? record->lower : record->higher;
+                if ( i == kLeaf )
+                {
+                    out[ walk[ w ].which ] = kIndexUnset;
+                }
+            }
+
+            if ( i != kLeaf )
+            {
+                __builtin_prefetch( &skipTable[ i ] );
+                walk[ w ].i = i;
+                w++;
+            }
+            else if ( next < n )
+            {
+                /* start the next lookup at the root, which is sure to be cached */
+                walk[ w ].which = next++;
+                walk[ w ].i     = 0;
+                w++;
+            }
+            else
+            {
+                /* nothing left to start, so close the gap */
+                walk[ w ] = walk[ --active ];
+            }
+        }
+    }
+}
+
+/*
+ * false means the hash is certainly not in the set; true means it probably is.
+ * All the probes fall in the same cache line, and are combined without branches.
+ */
+bool mayContainHash( const tFilter * filter, tHash hash )
+{
+    tHash mixed = perfectMix( hash, kFilterSeed );
+    const uint64_t * block = &filter->bits[ filterBlock( mixed, filter->blocks ) * ( kFilterBlockBits / 64 ) ];
+    uint64_t present = 1;
+
+    for ( uint32_t probe = 0; probe < filter->probes; probe++ )
+    {
+        uint32_t bit = filterBit( mixed, probe );
+        present &= block[ bit / 64 ] >> ( bit % 64 );
+    }
+    return ( present & 1 ) != 0;
+}
+
+tIndex findHashFiltered( const tFilter * filter, tRecord skipTable[], tHash hash )
+{
+    if ( !mayContainHash( filter, hash ))
+    {
+        return kIndexUnset;
+    }
+    return findHash( skipTable, hash );
+}
+
+/*
+ * The hashes are laid out as an implicit tree in breadth-first order, so the
+ * children of i are at 2i+1 and 2i+2, and the only thing in each step that
+ * depends on the comparison is arithmetic - no branch to mispredict.
+ */
+tIndex findHashEytzinger( const tHash hashes[],
+                          const tIndex indices[],
+                          unsigned int count,
+                          tHash hash )
+{
+    unsigned int i = 0;
+
+    while ( i < count )
+    {
+        /* the four grandchildren of i are adjacent, so one prefetch covers them */
+        __builtin_prefetch( &hashes[ 4 * i + 3 ] );
+        i = 2 * i + 1 + ( hashes[ i ] < hash );
+    }
+
+    /* i+1 is the 1-based position we fell off the bottom at. Each trailing 1 bit is
+     * a step to the right, and the last 0 bit is the left step taken at the lowest
+     * record that is not less than the hash - strip them all to get back to it */
+    i = ( i + 1 ) >> __builtin_ffs( ~( i + 1 ));
+
+    if ( i != 0 && hashes[ i - 1 ] == hash )
+    {
+        return indices[ i - 1 ];
+    }
+    return kIndexUnset;
+}
+
+/*
+ * The hashes are sorted, and kept apart from the indices (and the strings, if
+ * emitted), so the search only touches the hashes - eight to a cache line.
+ */
+tIndex findHashSplit( const tHash hashes[],
+                      const tIndex indices[],
+                      unsigned int count,
+                      tHash hash )
+{
+    const tHash * base = hashes;
+    unsigned int  n    = count;
+
+    if ( n == 0 )
+    {
+        return kIndexUnset;
+    }
+
+    while ( n > 1 )
+    {
+        unsigned int half = n / 2;
+        base = ( base[ half ] <= hash ) ? &base[ half ] : base;
+        n -= half;
+    }
+
+    return ( *base == hash ) ? indices[ base - hashes ] : kIndexUnset;
+}
+
+/* as findHashEytzinger(), for tables of 32-bit hashes */
+tIndex findHashEytzinger32( const tHash32 hashes[],
+                            const tIndex indices[],
+                            unsigned int count,
+                            tHash32 hash )
+{
+    unsigned int i = 0;
+
+    while ( i < count )
+    {
+        __builtin_prefetch( &hashes[ 4 * i + 3 ] );
+        i = 2 * i + 1 + ( hashes[ i ] < hash );
+    }
+
+    i = ( i + 1 ) >> __builtin_ffs( ~( i + 1 ));
+
+    if ( i != 0 && hashes[ i - 1 ] == hash )
+    {
+        return indices[ i - 1 ];
+    }
+    return kIndexUnset;
+}
+
+/* as findHashSplit(), for tables of 32-bit hashes */
+tIndex findHashSplit32( const tHash32 hashes[],
+                        const tIndex indices[],
+                        unsigned int count,
+                        tHash32 hash )
+{
+    const tHash32 * base = hashes;
+    unsigned int    n    = count;
+
+    if ( n == 0 )
+    {
+        return kIndexUnset;
+    }
+
+    while ( n > 1 )
+    {
+        unsigned int half = n / 2;
+        base = ( base[ half ] <= hash ) ? &base[ half ] : base;
+        n -= half;
+    }
+
+    return ( *base == hash ) ? indices[ base - hashes ] : kIndexUnset;
+}
+
+/*
+ * Static B-tree: kSTreeKeys sorted hashes per node, and the children of node k are
+ * k*(kSTreeKeys+1)+1 onwards, so a node's rank (how many of its hashes are lower
+ * than the one we want) picks the child directly. The rank of a whole node can be
+ * had with a vector compare and a movemask, where the CPU supports it.
+ */
+static inline unsigned int sTreeRankScalar( const tHash node[], tHash hash )
+{
+    unsigned int rank = 0;
+
+    for ( unsigned int i = 0; i < kSTreeKeys; i++ )
+    {
+        rank += ( node[ i ] < hash );
+    }
+    return rank;
+}
+
+static inline __attribute__(( always_inline ))
+tIndex sTreeSearch( const tHash hashes[],
+                    const tIndex indices[],
+                    unsigned int nodes,
+                    tHash hash,
+                    unsigned int (* rank)( const tHash node[], tHash hash ))
+{
+    unsigned int k = 0;
+    unsigned int candidate = 0;
+    bool         found = false;
+
+    while ( k < nodes )
+    {
+        unsigned int i = rank( &hashes[ k * kSTreeKeys ], hash );
+        if ( i < kSTreeKeys )
+        {
+            /* the lowest hash not less than the one we want, so far */
+            candidate = k * kSTreeKeys + i;
+            found = true;
+        }
+        k = k * ( kSTreeKeys + 1 ) + i + 1;
+    }
+
+    return ( found && hashes[ candidate ] == hash ) ? indices[ candidate ] : kIndexUnset;
+}
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+
+/* the vector compares are signed, so flip the sign bits to compare unsigned */
+#define kSignBit    ((long long)0x8000000000000000ULL)
+
+__attribute__(( target( "avx2" )))
+static inline unsigned int sTreeRankAVX2( const tHash node[], tHash hash )
+{
+    const __m256i bias = _mm256_set1_epi64x( kSignBit );
+    __m256i key = _mm256_xor_si256( _mm256_set1_epi64x( (long long)hash ), bias );
+    __m256i lo  = _mm256_xor_si256( _mm256_loadu_si256( (const __m256i *)&node[ 0 ] ), bias );
+    __m256i hi  = _mm256_xor_si256( _mm256_loadu_si256( (const __m256i *)&node[ 4 ] ), bias );
+
+    unsigned int mask = _mm256_movemask_pd( _mm256_castsi256_pd( _mm256_cmpgt_epi64( key, lo )))
+                     | ( _mm256_movemask_pd( _mm256_castsi256_pd( _mm256_cmpgt_epi64( key, hi ))) << 4 );
+    return __builtin_popcount( mask );
+}
+
+__attribute__(( target( "avx2" )))
+static tIndex findHashSTreeAVX2( const tHash hashes[], const tIndex indices[], unsigned int nodes, tHash hash )
+{
+    return sTreeSearch( hashes, indices, nodes, hash, sTreeRankAVX2 );
+}
+
+__attribute__(( target( "sse4.2,popcnt" )))
+static inline unsigned int sTreeRankSSE42( const tHash node[], tHash hash )
+{
+    const __m128i bias = _mm_set1_epi64x( kSignBit );
+    __m128i key = _mm_xor_si128( _mm_set1_epi64x( (long long)hash ), bias );
+    unsigned int mask = 0;
+
+    for ( unsigned int i = 0; i < kSTreeKeys; i += 2 )
+    {
+        __m128i pair = _mm_xor_si128( _mm_loadu_si128( (const __m128i *)&node[ i ] ), bias );
+        mask |= _mm_movemask_pd( _mm_castsi128_pd( _mm_cmpgt_epi64( key, pair ))) << i;
+    }
+    return __builtin_popcount( mask );
+}
+
+__attribute__(( target( "sse4.2,popcnt" )))
+static tIndex findHashSTreeSSE42( const tHash hashes[], const tIndex indices[], unsigned int nodes, tHash hash )
+{
+    return sTreeSearch( hashes, indices, nodes, hash, sTreeRankSSE42 );
+}
+
+#endif
+
+tIndex findHashSTree( const tHash hashes[],
+                      const tIndex indices[],
+                      unsigned int nodes,
+                      tHash hash )
+{
+#if defined( __x86_64__ ) || defined( __i386__ )
+    if ( __builtin_cpu_supports( "avx2" ))
+    {
+        return findHashSTreeAVX2( hashes, indices, nodes, hash );
+    }
+    if ( __builtin_cpu_supports( "sse4.2" ))
+    {
+        return findHashSTreeSSE42( hashes, indices, nodes, hash );
+    }
+#endif
+    return sTreeSearch( hashes, indices, nodes, hash, sTreeRankScalar );
+}
+
+/*
+ * A small table, scanned whole. count is a multiple of kScanPadding, and keys[] is
+ * the narrowHash() of each hash, so eight can be compared at once and each 64 keys
+ * make a single mask. Only a key that matches has its full hash compared. A 32-bit
+ * table has no keys, as its hashes are already narrow. The padding comes last,
+ * and its index is kIndexUnset.
+ */
+static inline tIndex scanCandidates( uint64_t mask,
+                                     const tHash hashes[],
+                                     const tIndex indices[],
+                                     tHash hash )
+{
+    while ( mask != 0 )
+    {
+        unsigned int i = __builtin_ctzll( mask );
+        if ( hashes[ i ] == hash )
+        {
+            return indices[ i ];
+        }
+        mask &= mask - 1;
+    }
+    return kIndexUnset;
+}
+
+static inline uint64_t scanMaskScalar( const tHash32 keys[], unsigned int n, tHash32 key )
+{
+    uint64_t mask = 0;
+
+    for ( unsigned int i = 0; i < n; i++ )
+    {
+        mask |= (uint64_t)( keys[ i ] == key ) << i;
+    }
+    return mask;
+}
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+
+/* n keys from a 32-byte aligned keys[], n a multiple of 8 and no more than 64 */
+__attribute__(( target( "avx2" )))
+static inline uint64_t scanMaskAVX2( const tHash32 keys[], unsigned int n, tHash32 key )
+{
+    __m256i  match = _mm256_set1_epi32( (int)key );
+    uint64_t mask  = 0;
+
+    for ( unsigned int i = 0; i < n; i += 8 )
+    {
+        __m256i equal = _mm256_cmpeq_epi32( _mm256_load_si256( (const __m256i *)&keys[ i ] ), match );
+        mask |= (uint64_t)_mm256_movemask_ps( _mm256_castsi256_ps( equal )) << i;
+    }
+    return mask;
+}
+
+__attribute__(( target( "avx2" )))
+static tIndex findHashScanAVX2( const tHash32 keys[],
+                                const tHash hashes[],
+                                const tIndex indices[],
+                                unsigned int count,
+                                tHash hash )
+{
+    tHash32 key = narrowHash( hash );
+
+    for ( unsigned int base = 0; base < count; base += 64 )
+    {
+        unsigned int n = ( count - base < 64 ) ? count - base : 64;
+        tIndex index = scanCandidates( scanMaskAVX2( &keys[ base ], n, key ),
+                                       &hashes[ base ], &indices[ base ], hash );
+        if ( index != kIndexUnset )
+        {
+            return index;
+        }
+    }
+    return kIndexUnset;
+}
+
+__attribute__(( target( "avx2" )))
+static tIndex findHashScan32AVX2( const tHash32 hashes[],
+                                  const tIndex indices[],
+                                  unsigned int count,
+                                  tHash32 hash )
+{
+    for ( unsigned int base = 0; base < count; base += 64 )
+    {
+        unsigned int n = ( count - base < 64 ) ? count - base : 64;
+        uint64_t mask = scanMaskAVX2( &hashes[ base ], n, hash );
+        if ( mask != 0 )
+        {
+            return indices[ base + __builtin_ctzll( mask ) ];
+        }
+    }
+    return kIndexUnset;
+}
+
+#endif
+
+tIndex findHashScan( const tHash32 keys[],
+                     const tHash hashes[],
+                     const tIndex indices[],
+                     unsigned int count,
+                     tHash hash )
+{
+#if defined( __x86_64__ ) || defined( __i386__ )
+    if ( __builtin_cpu_supports( "avx2" ))
+    {
+        return findHashScanAVX2( keys, hashes, indices, count, hash );
+    }
+#endif
+    tHash32 key = narrowHash( hash );
+
+    for ( unsigned int base = 0; base < count; base += 64 )
+    {
+        unsigned int n = ( count - base < 64 ) ? count - base : 64;
+        tIndex index = scanCandidates( scanMaskScalar( &keys[ base ], n, key ),
+                                       &hashes[ base ], &indices[ base ], hash );
+        if ( index != kIndexUnset )
+        {
+            return index;
+        }
+    }
+    return kIndexUnset;
+}
+
+tIndex findHashScan32( const tHash32 hashes[],
+                       const tIndex indices[],
+                       unsigned int count,
+                       tHash32 hash )
+{
+#if defined( __x86_64__ ) || defined( __i386__ )
+    if ( __builtin_cpu_supports( "avx2" ))
+    {
+        return findHashScan32AVX2( hashes, indices, count, hash );
+    }
+#endif
+    for ( unsigned int i = 0; i < count; i++ )
+    {
+        if ( hashes[ i ] == hash )
+        {
+            return indices[ i ];
+        }
+    }
+    return kIndexUnset;
+}
+
+/*
+ * Radix table: the hashes are grouped into buckets by radixBucket(), and offsets[]
+ * holds where each bucket starts (and, at the end, where the last one ends). Finding
+ * a hash is one offset load, then a scan of a short contiguous run of hashes.
+ */
+static inline tIndex radixScanScalar( const tHash hashes[],
+                                      const tIndex indices[],
+                                      uint32_t start,
+                                      uint32_t end,
+                                      tHash hash )
+{
+    for ( uint32_t i = start; i < end; i++ )
+    {
+        if ( hashes[ i ] == hash )
+        {
+            return indices[ i ];
+        }
+    }
+    return kIndexUnset;
+}
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+
+/* compares four hashes at a time, relying on the padding at the end of the table */
+__attribute__(( target( "avx2" )))
+static tIndex radixScanAVX2( const tHash hashes[],
+                             const tIndex indices[],
+                             uint32_t start,
+                             uint32_t end,
+                             tHash hash )
+{
+    __m256i key = _mm256_set1_epi64x( (long long)hash );
+
+    for ( uint32_t i = start; i < end; i += 4 )
+    {
+        __m256i four = _mm256_loadu_si256( (const __m256i *)&hashes[ i ] );
+        unsigned int mask = _mm256_movemask_pd( _mm256_castsi256_pd( _mm256_cmpeq_epi64( four, key )));
+        if ( mask != 0 )
+        {
+            uint32_t j = i + __builtin_ctz( mask );
+            return ( j < end ) ? indices[ j ] : kIndexUnset;
+        }
+    }
+    return kIndexUnset;
+}
+
+#endif
+
+tIndex findHashRadix( const uint32_t offsets[],
+                      unsigned int bits,
+                      const tHash hashes[],
+                      const tIndex indices[],
+                      tHash hash )
+{
+    uint32_t bucket = radixBucket( hash, bits );
+    uint32_t start  = offsets[ bucket ];
+    uint32_t end    = offsets[ bucket + 1 ];
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+    if ( end - start > 2 && __builtin_cpu_supports( "avx2" ))
+    {
+        return radixScanAVX2( hashes, indices, start, end, hash );
+    }
+#endif
+    return radixScanScalar( hashes, indices, start, end, hash );
+}
+
+/*
+ * Swiss table: a bit set in the result for each control byte in the group
+ * that matches 'control'. The vector (or SWAR) compare may report a false
+ * match, but never misses a true one - the caller checks the hash anyway.
+ */
+static inline uint32_t swissMatch( const uint8_t * group, uint32_t groupSize, uint8_t control )
+{
+#if defined( __SSE2__ )
+    if ( groupSize == 16 )
+    {
+        __m128i controls = _mm_loadu_si128( (const __m128i *)group );
+        return (uint32_t)_mm_movemask_epi8( _mm_cmpeq_epi8( controls, _mm_set1_epi8( (char)control )));
+    }
+#endif
+    uint32_t result = 0;
+    for ( uint32_t half = 0; half < groupSize; half += 8 )
+    {
+        uint64_t word;
+        memcpy( &word, &group[ half ], sizeof( word ));
+        /* a zero byte wherever the control byte matches, then the usual zero byte test */
+        word ^= 0x0101010101010101ULL * control;
+        word = ( word - 0x0101010101010101ULL ) & ~word & 0x8080808080808080ULL;
+        /* gather the high bit of each byte into the low 8 bits */
+        result |= (uint32_t)((( word >> 7 ) * 0x0102040810204080ULL ) >> 56 ) << half;
+    }
+    return result;
+}
+
+static inline bool swissHasEmpty( const uint8_t * group, uint32_t groupSize )
+{
+    uint64_t word;
+    for ( uint32_t half = 0; half < groupSize; half += 8 )
+    {
+        memcpy( &word, &group[ half ], sizeof( word ));
+        if (( word & 0x8080808080808080ULL ) != 0 )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * probe the groups in triangular order until the hash is found, or a group
+ * with an empty slot shows that it is not in the table
+ */
+tIndex findHashSwiss( const tSwissTable * table, tHash hash )
+{
+    tHash    mixed   = perfectMix( hash, kSwissSeed );
+    uint8_t  control = swissControl( mixed );
+    uint32_t mask    = ( 1U << table->groupBits ) - 1;
+    uint32_t group   = swissGroup( mixed, table->groupBits );
+
+    for ( uint32_t step = 1; step <= mask + 1; step++ )
+    {
+        const uint8_t * controls = &table->control[ group * table->groupSize ];
+        uint32_t match = swissMatch( controls, table->groupSize, control );
+
+        while ( match != 0 )
+        {
+            const tSlot * slot = &table->slot[ group * table->groupSize + __builtin_ctz( match ) ];
+            if ( slot->hash == hash )
+            {
+                return slot->index;
+            }
+            match &= match - 1;
+        }
+
+        if ( swissHasEmpty( controls, table->groupSize ))
+        {
+            break;
+        }
+        group = ( group + step ) & mask;
+    }
+    return kIndexUnset;
+}
+
+/*
+ * No hash at all: walk the trie a byte at a time, and give up as soon as
+ * no keyword continues with that character - often the very first one.
+ */
+tIndex matchTrie( const tTrie * trie, const char * string, size_t length )
+{
+    const unsigned char * p = (const unsigned char *)string;
+    uint32_t state = kTrieRoot;
+
+    while ( length-- > 0 )
+    {
+        uint32_t next = trie->node[ state ].base + trie->charClass[ *p++ ];
+        if ( trie->node[ next ].check != state )
+        {
+            return kIndexUnset;
+        }
+        state = next;
+    }
+    return trie->accept[ state ];
+}
+
+/*
+ * Reject a string whose length or first character no keyword has before
+ * spending any time hashing it, and otherwise search only the sub-table of
+ * the keywords that share both.
+ */
+tIndex findHashDispatch( const tDispatch * dispatch,
+                         const tCharMap * charMap,
+                         const char * string,
+                         size_t length )
+{
+    if ( length == 0 || length > dispatch->maxLength )
+    {
+        return kIndexUnset;
+    }
+
+    uint32_t class = dispatch->charClass[ (unsigned char)string[ 0 ] ];
+    if ( class == 0 )
+    {
+        return kIndexUnset;
+    }
+
+    size_t   bucket = ( length < dispatch->lengths ) ? length : dispatch->lengths - 1;
+    uint32_t cell   = bucket * dispatch->classes + class;
+    uint32_t first  = dispatch->offset[ cell ];
+    uint32_t end    = dispatch->offset[ cell + 1 ];
+    if ( first == end )
+    {
+        return kIndexUnset;
+    }
+
+    tHash    hash = ( dispatch->wordMap != NULL )
+                  ? hashStringWord( dispatch->wordMap, dispatch->seed, string, length )
+                  : hashStringWith( dispatch->function, dispatch->seed, string, length, charMap );
+    uint32_t last = end;
+    while ( first < last )
+    {
+        uint32_t middle = first + ( last - first ) / 2;
+        if ( dispatch->hash[ middle ] < hash )
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+    return ( first < end && dispatch->hash[ first ] == hash ) ? dispatch->index[ first ] : kIndexUnset;
+}
+
+/*
+ * constant time: one load of the bucket's displacement, one load of the
+ * slot it leads to, and a single comparison to reject anything else
+ */
+tIndex findHashPerfect( const tPerfectHash * table, tHash hash )
+{
+    tHash mixed = perfectMix( hash, table->seed );
+    uint32_t displace = table->displace[ perfectBucket( mixed, table->buckets ) ];
+    const tSlot * slot = &table->slot[ perfectSlot( mixed, displace, table->count ) ];
+
+    return ( slot->hash == hash ) ? slot->index : kIndexUnset;
 }
 
 void dumpHashMap( FILE * out, tRecord skipTable[] )
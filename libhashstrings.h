@@ -6,9 +6,18 @@
 #define HASHSTRINGS_LIBHASHSTRINGS_H
 
 #include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <sys/uio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 typedef void           tNode;
 typedef uint64_t       tHash;
+typedef uint32_t       tHash32;
 typedef uint32_t       tIndex;
 #define kIndexUnset	   0
 
@@ -17,6 +26,45 @@ typedef unsigned short tMappedChar;
 
 #define kLeaf   0
 
+/* the functions a dictionary can be hashed with. Each hashes the mapped characters,
+ * so the character map applies whichever is chosen */
+typedef enum {
+    kHashLegacy = 0,    /* hash ^ ((hash * 43) + c), a character at a time */
+    kHashFNV1a,         /* 64-bit FNV-1a, a character at a time */
+    kHashWyhash,        /* four characters at a time, mixed by a 64 x 64 -> 128-bit multiply */
+    kHashCRC32C,        /* four characters at a time, into two CRC32Cs (SSE4.2, if the CPU has it) */
+    kHashWord,          /* eight characters at a time, each folded to a byte (see tWordMap) */
+    kHashPolynomial     /* K^n + the sum of c[i] * K^(n-1-i), so chunks can be hashed in parallel */
+} tHashFunction;
+
+/* for the word hash: the character map as one byte per byte, 'fold' - each byte
+ * becomes the lowest byte with the same mapped character. As well, the runs of
+ * ASCII bytes that fold to a fixed offset below themselves (a case fold) or all
+ * to one byte (a class), so eight ASCII bytes can be folded at once, with SWAR.
+ * Past kWordRanges runs a table lookup per byte is quicker, and 'ranges' is 0 */
+#define kWordRanges 4
+
+typedef struct {
+    uint8_t          first, last;
+    uint8_t          subtract;      /* folds to the byte minus this, or if it's zero... */
+    uint8_t          value;         /* ...to this */
+} tWordRange;
+
+typedef struct {
+    uint8_t          fold[256];
+    uint32_t         ranges;
+    tWordRange       range[kWordRanges];
+} tWordMap;
+
+/* the state of a (legacy) hash built up a piece at a time, for input that isn't contiguous */
+typedef struct {
+    tHash            hash;
+    const tCharMap * charMap;
+} tHashContext;
+
+/* hashes per node of a static B-tree - one 64-byte cache line */
+#define kSTreeKeys  8
+
 /* don't need name - use lookup<prefix>asString[index] instead
  * otherwise the 'name' strings may be duplicated */
 typedef struct {
@@ -27,20 +75,316 @@ typedef struct {
 } tRecord;
 
 
-extern tMappedChar remapChar( tCharMap * charMap,
+/* one slot of a minimal perfect hash table */
+typedef struct {
+    tHash        hash;
+    tIndex       index;
+} tSlot;
+
+/* a minimal perfect hash: the keys are spread into buckets, and each bucket
+ * has a displacement that moves its keys to otherwise-unoccupied slots */
+typedef struct {
+    tHash            seed;
+    uint32_t         buckets;
+    uint32_t         count;
+    const uint32_t * displace;
+    const tSlot    * slot;
+} tPerfectHash;
+
+/* a blocked Bloom filter: each hash sets 'probes' bits within one 512-bit
+ * (cache line) block, so a query never touches more than one cache line */
+typedef struct {
+    uint32_t         blocks;
+    uint32_t         probes;
+    const uint64_t * bits;
+} tFilter;
+
+#define kFilterBlockBits    512
+#define kFilterSeed         0x2545f4914f6cdd1dULL
+
+/* open addressing, in groups of 8 or 16 slots: each slot has a control byte, either
+ * kSwissEmpty or 7 bits of its hash, so a whole group can be filtered at once */
+typedef struct {
+    uint32_t        groupBits;      /* log2 of the number of groups */
+    uint32_t        groupSize;
+    const uint8_t * control;
+    const tSlot   * slot;
+} tSwissTable;
+
+#define kSwissEmpty     0x80
+#define kSwissSeed      0x6a09e667f3bcc909ULL
+
+/* a double-array trie over the mapped characters: charClass[] turns an input byte
+ * into the label of its mapped character (0 if no keyword contains it), and the
+ * child of state s labelled c is state t = node[s].base + c, if node[t].check == s */
+typedef struct {
+    uint32_t     base;
+    uint32_t     check;
+} tTrieNode;
+
+typedef struct {
+    const uint16_t  * charClass;
+    const tTrieNode * node;
+    const tIndex    * accept;
+} tTrie;
+
+#define kTrieRoot   1
+
+/* a screen in front of the hashing: the strings of each (length, first character)
+ * pair have a sorted sub-table of their own, and most pairs have none at all.
+ * Lengths from lengths-1 up to maxLength share the last length bucket */
+typedef struct {
+    uint32_t          maxLength;
+    uint32_t          lengths;      /* number of length buckets */
+    uint32_t          classes;      /* first-character classes, including 0 for 'none' */
+    const uint16_t  * charClass;    /* byte -> class of a keyword's first character */
+    const uint32_t  * offset;       /* cell (bucket * classes + class) -> its sub-table */
+    const tHash     * hash;
+    const tIndex    * index;
+    tHashFunction     function;
+    tHash             seed;
+    const tWordMap  * wordMap;      /* for kHashWord, so it needn't be built for every string */
+} tDispatch;
+
+/* the hashed strings of each keyword, for confirming a match: offset[k-1] to
+ * offset[k] of bytes[] holds keyword k's strings, each preceded by its length */
+typedef struct {
+    const uint32_t * offset;
+    const char     * bytes;
+} tStringPool;
+
+/* shared by the generator and the lookup, so they always agree */
+static inline tHash perfectMix( tHash hash, tHash seed )
+{
+    hash ^= seed;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static inline uint32_t perfectBucket( tHash mixed, uint32_t buckets )
+{
+    return (uint32_t)((( mixed >> 32 ) * buckets ) >> 32 );
+}
+
+static inline uint32_t perfectSlot( tHash mixed, uint32_t displace, uint32_t count )
+{
+    uint32_t x = (uint32_t)mixed ^ displace;
+
+    x ^= x >> 16;
+    x *= 0x85ebca6bU;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35U;
+    x ^= x >> 16;
+    return (uint32_t)(((uint64_t)x * count ) >> 32 );
+}
+
+/* the top bits of a Fibonacci hash - short strings leave the top bits of their
+ * hashes zero, so the hash's own top bits would not spread them evenly */
+static inline uint32_t radixBucket( tHash hash, unsigned int bits )
+{
+    return ( bits == 0 ) ? 0 : (uint32_t)(( hash * 0x9e3779b97f4a7c15ULL ) >> ( 64 - bits ));
+}
+
+static inline uint32_t swissGroup( tHash mixed, uint32_t groupBits )
+{
+    return ( groupBits == 0 ) ? 0 : (uint32_t)( mixed >> ( 64 - groupBits ));
+}
+
+static inline uint8_t swissControl( tHash mixed )
+{
+    return (uint8_t)( mixed & 0x7f );
+}
+
+/* extra hashes at the end of a radix table, so a vector scan can't read past it */
+#define kRadixPadding   3
+
+/* a scan table's entries are a multiple of this many, and what is scanned is 32-byte aligned */
+#define kScanPadding    8
+
+static inline uint32_t filterBlock( tHash mixed, uint32_t blocks )
+{
+    return (uint32_t)((( mixed >> 32 ) * blocks ) >> 32 );
+}
+
+static inline uint32_t filterBit( tHash mixed, uint32_t probe )
+{
+    uint32_t lo = (uint32_t)mixed;
+    return ( lo + probe * (( lo >> 9 ) | 1 )) & ( kFilterBlockBits - 1 );
+}
+
+/* fold a hash to 32 bits, for dictionaries that are collision-free at that width */
+static inline tHash32 narrowHash( tHash hash )
+{
+    return (tHash32)( hash ^ ( hash >> 32 ));
+}
+
+/*
+ * A complete tree of 2^depth - 1 hashes in breadth-first order, from hashes[1]
+ * (hashes[0] is a dummy), padded with sentinel hashes. Every search takes exactly
+ * 'depth' steps, and each step is a pair of conditional moves rather than a branch.
+ * Inline, so when depth is a constant the loop can be unrolled completely.
+ */
+static inline tIndex findHashComplete( const tHash hashes[],
+                                       const tIndex indices[],
+                                       unsigned int depth,
+                                       tHash hash )
+{
+    unsigned int i = 1;
+    unsigned int candidate = 0;     /* the lowest hash seen that is not less than the hash */
+
+#pragma GCC unroll 32
+    for ( unsigned int level = 0; level < depth; level++ )
+    {
+        tHash node = hashes[ i ];
+        candidate = ( hash <= node ) ? i : candidate;
+        i = 2 * i + ( hash > node );
+    }
+    return ( hashes[ candidate ] == hash ) ? indices[ candidate ] : kIndexUnset;
+}
+
+extern tMappedChar remapChar( const tCharMap * charMap,
                               const unsigned char c );
 
+extern void remapBuffer( const tCharMap * charMap,
+                         const uint8_t * in,
+                         tMappedChar * out,
+                         size_t n );
+
 extern tHash hashChar( tHash hash,
                        const tMappedChar mappedC );
 
 extern tHash hashString(const char * string, tCharMap * charMap );
 
+extern tHash hashStringWith( tHashFunction function,
+                             tHash seed,
+                             const char * string,
+                             size_t length,
+                             const tCharMap * charMap );
+
+extern void buildWordMap( const tCharMap * charMap, tWordMap * wordMap );
+
+extern tHash hashStringWord( const tWordMap * wordMap,
+                             tHash seed,
+                             const char * string,
+                             size_t length );
+
+extern tHash hashStringFlat( const char * string, const uint16_t flatMap[256] );
+
+extern tHash hashStringFlat8( const char * string, const uint8_t flatMap[256] );
+
+extern tHash32 hashString32( const char * string, tCharMap * charMap );
+
+extern tHash hashStringN( const char * string, size_t length, const tCharMap * charMap );
+
+extern void hashInit( tHashContext * context, const tCharMap * charMap );
+
+extern void hashUpdate( tHashContext * context, const void * bytes, size_t length );
+
+extern tHash hashFinal( const tHashContext * context );
+
+extern tHash hashIovec( const struct iovec * iov, int iovcnt, const tCharMap * charMap );
+
+extern void hashStringBatch( const char * const * strs,
+                             const size_t * lens,
+                             size_t n,
+                             const tCharMap * charMap,
+                             tHash * out );
+
+extern bool verifyMatch( const tStringPool * pool,
+                         const tCharMap * charMap,
+                         tIndex index,
+                         const char * string,
+                         size_t length );
+
+extern tIndex findHashVerified( tRecord skipTable[],
+                                const tStringPool * pool,
+                                const tCharMap * charMap,
+                                const char * string,
+                                size_t length );
+
 extern tIndex findHash( tRecord skipTable[], tHash hash );
 
+extern tIndex findHashN( tRecord skipTable[],
+                         const tCharMap * charMap,
+                         const char * string,
+                         size_t length );
+
+extern void findHashBatch( const tRecord skipTable[],
+                           const tHash * hashes,
+                           tIndex * out,
+                           size_t n );
+
+extern bool mayContainHash( const tFilter * filter, tHash hash );
+
+extern tIndex findHashFiltered( const tFilter * filter,
+                                tRecord skipTable[],
+                                tHash hash );
+
+extern tIndex findHashEytzinger( const tHash hashes[],
+                                 const tIndex indices[],
+                                 unsigned int count,
+                                 tHash hash );
+
+extern tIndex findHashSplit( const tHash hashes[],
+                             const tIndex indices[],
+                             unsigned int count,
+                             tHash hash );
+
+extern tIndex findHashEytzinger32( const tHash32 hashes[],
+                                   const tIndex indices[],
+                                   unsigned int count,
+                                   tHash32 hash );
+
+extern tIndex findHashSplit32( const tHash32 hashes[],
+                               const tIndex indices[],
+                               unsigned int count,
+                               tHash32 hash );
+
+extern tIndex findHashScan( const tHash32 keys[],
+                            const tHash hashes[],
+                            const tIndex indices[],
+                            unsigned int count,
+                            tHash hash );
+
+extern tIndex findHashScan32( const tHash32 hashes[],
+                              const tIndex indices[],
+                              unsigned int count,
+                              tHash32 hash );
+
+extern tIndex findHashRadix( const uint32_t offsets[],
+                             unsigned int bits,
+                             const tHash hashes[],
+                             const tIndex indices[],
+                             tHash hash );
+
+extern tIndex findHashSTree( const tHash hashes[],
+                             const tIndex indices[],
+                             unsigned int nodes,
+                             tHash hash );
+
+extern tIndex findHashSwiss( const tSwissTable * table, tHash hash );
+
+extern tIndex matchTrie( const tTrie * trie, const char * string, size_t length );
+
+extern tIndex findHashDispatch( const tDispatch * dispatch,
+                                const tCharMap * charMap,
+                                const char * string,
+                                size_t length );
+
+extern tIndex findHashPerfect( const tPerfectHash * table, tHash hash );
+
 extern void setCharMap( tCharMap * charMap,
                         const unsigned char c,
                         const tMappedChar mappedC );
 
 void dumpHashMap( FILE * out, tRecord skipTable[] );
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif //HASHSTRINGS_LIBHASHSTRINGS_H
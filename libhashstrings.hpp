@@ -0,0 +1,209 @@
+//
+// constexpr versions of the hashes in libhashstrings.c, for C++17 and later
+//
+
+#ifndef HASHSTRINGS_LIBHASHSTRINGS_HPP
+#define HASHSTRINGS_LIBHASHSTRINGS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "libhashstrings.h"
+
+/*
+ * Each of these mirrors its namesake in libhashstrings.c step for step, so a
+ * string hashed at compile time has exactly the hash the runtime (and the
+ * generator) would give it. The generated header builds a user-defined literal,
+ * "..."_hs<Prefix>, from them and the dictionary's own character map.
+ */
+namespace hashstrings
+{
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 tProduct;
+#endif
+
+    constexpr tMappedChar remapChar( const tCharMap * charMap, unsigned char c )
+    {
+        return (tMappedChar)(( charMap[ c / 7 ] >> (( c % 7 ) * 9 )) & 0x01ff );
+    }
+
+    constexpr tHash hashChar( tHash hash, tMappedChar mappedC, tHash factor = 43 )
+    {
+        return ( hash ^ (( hash * factor ) + mappedC ));
+    }
+
+    constexpr tHash32 narrowHash( tHash hash )
+    {
+        return (tHash32)( hash ^ ( hash >> 32 ));
+    }
+
+    /* stops at the first character that maps to '\0', which includes the terminator */
+    constexpr tHash hashString( const char * string, const tCharMap * charMap )
+    {
+        tHash hash = 0;
+
+        for ( const char * p = string; ; p++ )
+        {
+            tMappedChar c = remapChar( charMap, (unsigned char)*p );
+            if ( c == '\0' )
+            {
+                break;
+            }
+            hash = hashChar( hash, c );
+        }
+        return hash;
+    }
+
+    constexpr tHash hashStringN( const char * string, std::size_t length, const tCharMap * charMap )
+    {
+        tHash hash = 0;
+
+        for ( std::size_t i = 0; i < length; i++ )
+        {
+            hash = hashChar( hash, remapChar( charMap, (unsigned char)string[ i ] ));
+        }
+        return hash;
+    }
+
+    constexpr uint64_t wyMix( uint64_t a, uint64_t b )
+    {
+#ifdef __SIZEOF_INT128__
+        tProduct product = (tProduct)a * b;
+        return (uint64_t)product ^ (uint64_t)( product >> 64 );
+#else
+        uint64_t lowA  = a & 0xffffffff, highA = a >> 32;
+        uint64_t lowB  = b & 0xffffffff, highB = b >> 32;
+        uint64_t cross = lowA * highB;
+        uint64_t other = highA * lowB;
+        uint64_t carry = (( lowA * lowB ) >> 32 ) + ( cross & 0xffffffff ) + ( other & 0xffffffff );
+        uint64_t high  = highA * highB + ( cross >> 32 ) + ( other >> 32 ) + ( carry >> 32 );
+        return ( a * b ) ^ high;
+#endif
+    }
+
+    constexpr uint32_t crc32c( uint32_t crc, uint64_t word )
+    {
+        uint64_t x = crc ^ word;
+
+        for ( int i = 0; i < 64; i++ )
+        {
+            x = ( x >> 1 ) ^ ( 0x82f63b78U & -( x & 1 ));
+        }
+        return (uint32_t)x;
+    }
+
+    /* up to four mapped characters as one word - a short one at the end is zero filled */
+    constexpr uint64_t packMapped( const char * string, std::size_t n, const tCharMap * charMap )
+    {
+        uint64_t word = 0;
+
+        for ( std::size_t i = 0; i < n && i < 4; i++ )
+        {
+            word |= (uint64_t)remapChar( charMap, (unsigned char)string[ i ] ) << ( 16 * i );
+        }
+        return word;
+    }
+
+    /* only the fold of buildWordMap() - the SWAR runs fold each word the same way */
+    constexpr tHash hashStringWord( tHash seed,
+                                    const char * string,
+                                    std::size_t length,
+                                    const tCharMap * charMap )
+    {
+        uint8_t  fold[ 256 ] = {};
+        uint16_t lowest[ 512 ] = {};
+
+        for ( unsigned int c = 0; c < 256; c++ )
+        {
+            tMappedChar mapped = remapChar( charMap, (unsigned char)c );
+            if ( lowest[ mapped ] == 0 )
+            {
+                lowest[ mapped ] = (uint16_t)( c + 1 );
+            }
+            fold[ c ] = (uint8_t)( lowest[ mapped ] - 1 );
+        }
+
+        tHash hash = seed;
+        for ( std::size_t i = 0; i < length; i += 8 )
+        {
+            uint64_t word = 0;
+            for ( std::size_t j = 0; j < 8 && i + j < length; j++ )
+            {
+                word |= (uint64_t)fold[ (unsigned char)string[ i + j ] ] << ( 8 * j );
+            }
+            hash = wyMix( word ^ 0xe7037ed1a0b428dbULL, hash ^ 0xa0761d6478bd642fULL );
+        }
+        return wyMix( hash ^ length, 0x8ebc6af09c88c6e3ULL );
+    }
+
+    constexpr tHash hashStringWith( tHashFunction function,
+                                    tHash seed,
+                                    const char * string,
+                                    std::size_t length,
+                                    const tCharMap * charMap )
+    {
+        tHash hash = 0;
+
+        switch ( function )
+        {
+        case kHashWord:
+            hash = hashStringWord( seed, string, length, charMap );
+            break;
+
+        case kHashPolynomial:
+            hash = 1;
+            for ( std::size_t i = 0; i < length; i++ )
+            {
+                hash = hash * (( seed == 0 ) ? 0x9fb21c651e98df25ULL : ( seed | 1 ))
+                     + remapChar( charMap, (unsigned char)string[ i ] );
+            }
+            break;
+
+        case kHashLegacy:
+            for ( std::size_t i = 0; i < length; i++ )
+            {
+                hash = hashChar( hash, remapChar( charMap, (unsigned char)string[ i ] ),
+                                 ( seed == 0 ) ? 43 : ( seed | 1 ));
+            }
+            break;
+
+        case kHashFNV1a:
+            hash = 0xcbf29ce484222325ULL ^ seed;
+            for ( std::size_t i = 0; i < length; i++ )
+            {
+                hash = ( hash ^ remapChar( charMap, (unsigned char)string[ i ] )) * 0x00000100000001b3ULL;
+            }
+            break;
+
+        case kHashWyhash:
+            hash = seed;
+            for ( std::size_t i = 0; i < length; i += 4 )
+            {
+                hash = wyMix( packMapped( &string[ i ], length - i, charMap ) ^ 0xe7037ed1a0b428dbULL,
+                              hash ^ 0xa0761d6478bd642fULL );
+            }
+            hash = wyMix( hash ^ length, 0x8ebc6af09c88c6e3ULL );
+            break;
+
+        case kHashCRC32C:
+        default:
+            {
+                hash = ~0ULL ^ seed;
+                uint32_t a = (uint32_t)hash;
+                uint32_t b = (uint32_t)( hash >> 32 );
+                for ( std::size_t i = 0; i < length; i += 4 )
+                {
+                    uint64_t word = packMapped( &string[ i ], length - i, charMap );
+                    a = crc32c( a, word );
+                    b = crc32c( b, word * 0x9e3779b97f4a7c15ULL );
+                }
+                hash = ((tHash)crc32c( b, ~(uint64_t)length ) << 32 ) | crc32c( a, length );
+            }
+            break;
+        }
+        return hash;
+    }
+}
+
+#endif //HASHSTRINGS_LIBHASHSTRINGS_HPP